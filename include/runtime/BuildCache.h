@@ -0,0 +1,50 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "runtime/Export.h"
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+//! Directory of build artifacts indexed by a key identifying everything that went into them. Several apps can share the same directory.
+class CI_RT_API BuildCache {
+public:
+	explicit BuildCache( const ci::fs::path &directory );
+
+	//! Copies the files stored under key to paths, matching them by filename, and adds the ones copied to fetchedPaths if not null. Returns false if there's no entry for key or if the first path is missing from it
+	bool fetch( const std::string &key, const std::vector<ci::fs::path> &paths, std::vector<ci::fs::path>* fetchedPaths = nullptr ) const;
+	//! Stores the existing files among paths under key. Does nothing if the entry already exists
+	void store( const std::string &key, const std::vector<ci::fs::path> &paths ) const;
+
+	//! Returns the directory of the cache
+	const ci::fs::path& getDirectory() const { return mDirectory; }
+
+protected:
+	ci::fs::path mDirectory;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
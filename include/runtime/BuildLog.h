@@ -0,0 +1,132 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "runtime/Export.h"
+
+//! Queues the message streamed by args to the build log, without formatting it if nothing listens to category. ex. RT_BUILD_LOG( rt::BuildLog::Category::Info, "1>  " << path.filename() );
+#define RT_BUILD_LOG( category, args ) do { \
+	if( rt::BuildLog::instance().isEnabled( category ) ) { \
+		std::ostringstream rtBuildLogStream; \
+		rtBuildLogStream << args; \
+		rt::BuildLog::instance().write( category, rtBuildLogStream.str() ); \
+	} \
+} while( 0 )
+
+namespace runtime {
+
+//! Buffered sink of the build output, written to the console and to the listeners from a background thread so that builds never block the app
+class CI_RT_API BuildLog {
+public:
+	enum class Category {
+		//! Build banners, outputs and results
+		Info,
+		//! Compiler and linker warnings, rate limited
+		Warning,
+		//! Compiler and linker errors, never dropped
+		Error,
+		//! Command lines and raw job output of verbose builds, rate limited
+		Verbose
+	};
+
+	//! Single line of the build log
+	struct Message {
+		Category								mCategory;
+		std::string								mText;
+		std::chrono::system_clock::time_point	mTimePoint;
+	};
+
+	//! Returns the global BuildLog instance
+	static BuildLog& instance();
+
+	//! Returns whether a message of category would reach the console or a listener. Lets callers skip formatting messages nobody reads
+	bool isEnabled( Category category ) const { return isCategoryEnabled( category ) && ( mConsoleEnabled || mNumListeners > 0 ); }
+	//! Queues a message, written from the background thread. Messages of a disabled category are dropped, Warning and Verbose messages past the rate limit are dropped and counted
+	void write( Category category, std::string text );
+	//! Blocks until every queued message has been written
+	void flush();
+	//! Writes the messages still queued and stops the background thread, the messages written afterward are dropped. Called by Factory when the app cleans up, 
+	//! as the console can already be gone by the time the static instance is destroyed
+	void shutdown();
+
+	//! Enables writing the messages to app::console(). Enabled by default
+	void setConsoleEnabled( bool enabled ) { mConsoleEnabled = enabled; }
+	//! Returns whether the messages are written to app::console()
+	bool isConsoleEnabled() const { return mConsoleEnabled; }
+	//! Enables the messages of category. Every category is enabled by default, disabling Verbose or Warning skips their formatting even when writing to the console
+	void setCategoryEnabled( Category category, bool enabled );
+	//! Returns whether the messages of category are enabled
+	bool isCategoryEnabled( Category category ) const { return ( mEnabledCategories & getCategoryMask( category ) ) != 0; }
+	//! Sets how many Warning and Verbose messages can be queued per second, 0 meaning no limit. Defaults to 200
+	void setRateLimit( size_t messagesPerSecond );
+	//! Returns the number of messages dropped by the rate limit so far
+	size_t getNumDroppedMessages() const { return mNumDroppedMessages; }
+
+	//! Adds a function called from the background thread with each message. Returns an id for removeListener
+	size_t addListener( const std::function<void(const Message&)> &listener );
+	//! Removes a listener. Once this returns it won't be called anymore
+	void removeListener( size_t id );
+
+	~BuildLog();
+protected:
+	BuildLog();
+	void run();
+
+	static uint32_t getCategoryMask( Category category ) { return 1u << static_cast<uint32_t>( category ); }
+
+	std::mutex				mMutex;
+	std::condition_variable	mWakeUp;
+	std::condition_variable	mDrained;
+	std::deque<Message>		mMessages;
+	bool					mWriting;
+	bool					mRunning;
+
+	std::atomic<bool>		mConsoleEnabled;
+	std::atomic<uint32_t>	mEnabledCategories;
+	std::atomic<size_t>		mNumListeners;
+	std::mutex				mListenersMutex;
+	std::map<size_t,std::function<void(const Message&)>>	mListeners;
+	size_t					mNextListenerId;
+
+	size_t					mRateLimit;
+	std::chrono::steady_clock::time_point	mRateWindowStart;
+	size_t					mNumRateWindowMessages;
+	size_t					mNumRateWindowDropped;
+	std::atomic<size_t>		mNumDroppedMessages;
+
+	std::thread				mThread;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
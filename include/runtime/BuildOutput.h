@@ -20,12 +20,23 @@
 */
 #pragma once
 
+#include <chrono>
+#include <functional>
+
 #include "runtime/BuildSettings.h"
+#include "runtime/CompilerProfile.h"
+#include "runtime/Diagnostic.h"
 
 namespace runtime {
 
 class CI_RT_API BuildOutput {
 public:
+	//! Time spent by one of the compiler or linker jobs of the build
+	struct JobTiming {
+		std::string								mName;
+		std::chrono::steady_clock::duration		mDuration;
+	};
+
 	//! Returns the path of the compilation output
 	ci::fs::path getOutputPath() const;
 	//! Returns the path of the file that has been compiled
@@ -48,11 +59,31 @@ public:
 	const std::vector<std::string>& getWarnings() const;
 	//! Returns the list of warnings
 	std::vector<std::string>&		getWarnings();
+	//! Returns the errors, warnings and notes of the compiler and the linker, in the order they were reported
+	const std::vector<Diagnostic>&	getDiagnostics() const;
+	//! Returns the errors, warnings and notes of the compiler and the linker, in the order they were reported
+	std::vector<Diagnostic>&		getDiagnostics();
 	
 	//! Returns the settings used to execute that build
 	const BuildSettings& getBuildSettings() const;
 	//! Returns when this build started
 	std::chrono::system_clock::time_point getTimePoint() const;
+	//! Returns the time spent by each job of the build, in the order they finished
+	const std::vector<JobTiming>&	getJobTimings() const;
+	//! Returns the time spent by each job of the build, in the order they finished
+	std::vector<JobTiming>&			getJobTimings();
+	//! Returns the headers included by the translation units, as reported by the compiler. Empty if nothing has been compiled
+	const std::vector<ci::fs::path>&	getDependencies() const;
+	//! Returns the headers included by the translation units, as reported by the compiler. Empty if nothing has been compiled
+	std::vector<ci::fs::path>&			getDependencies();
+
+	//! Returns the time the compiler reported spending on phases, headers and definitions. Empty unless BuildSettings::compilerProfiling is enabled
+	const CompilerProfile&	getCompilerProfile() const;
+	//! Returns the time the compiler reported spending on phases, headers and definitions. Empty unless BuildSettings::compilerProfiling is enabled
+	CompilerProfile&		getCompilerProfile();
+
+	//! Returns the function resolving the symbols of a module linked in memory, or an empty function if the module is the file at getOutputPath()
+	const std::function<void*(const std::string&)>& getSymbolLookup() const;
 
 	//! Sets the path of the compilation output
 	void setOutputPath( const ci::fs::path &path );
@@ -60,6 +91,8 @@ public:
 	void setPdbFilePath( const ci::fs::path &path );
 	//! Sets the settings used to execute that build
 	void setBuildSettings( const BuildSettings &settings );
+	//! Sets the function resolving the symbols of a module linked in memory
+	void setSymbolLookup( const std::function<void*(const std::string&)> &symbolLookup );
 
 	BuildOutput();
 
@@ -70,6 +103,11 @@ protected:
 	std::vector<ci::fs::path> mObjectFilePaths;
 	std::vector<std::string> mErrors;
 	std::vector<std::string> mWarnings;
+	std::vector<Diagnostic> mDiagnostics;
+	std::vector<JobTiming> mJobTimings;
+	std::vector<ci::fs::path> mDependencies;
+	CompilerProfile mCompilerProfile;
+	std::function<void*(const std::string&)> mSymbolLookup;
 	BuildSettings mBuildSettings;
 	std::chrono::system_clock::time_point mTimePoint;
 };
@@ -26,23 +26,38 @@
 
 #include "runtime/Export.h"
 #include "runtime/BuildStep.h"
+#include "runtime/CopyOnWrite.h"
+#include "runtime/Process.h"
 #include "cinder/Filesystem.h"
 
 namespace runtime {
 
-//! Describes the list of Options and arguments available when building a file
+//! Describes the list of Options and arguments available when building a file. The lists are shared between copies until modified, so copies are cheap
 class CI_RT_API BuildSettings {
 public:
+	//! Optimization level of the generated code (/Od /O1 /O2 /Ox, -O0 -Os -O2 -O3)
+	enum class Optimization { Default, Disabled, MinSpace, MaxSpeed, Full };
+	//! Functions considered for inlining (/Ob0 /Ob1 /Ob2, -fno-inline -fno-inline-functions -finline-functions)
+	enum class InlineFunctionExpansion { Default, Disabled, OnlyExplicitInline, AnySuitable };
+	//! Instruction set extensions the generated code can use (/arch, -m)
+	enum class InstructionSet { Default, NoExtensions, SSE, SSE2, AVX, AVX2, AVX512 };
+	//! Floating point semantics (/fp, -ffp-contract=off, -frounding-math, -ffast-math)
+	enum class FloatingPointModel { Default, Precise, Strict, Fast };
+	//! Whether the optimizations favor the size or the speed of the code (/Os /Ot, -Os)
+	enum class FavorSizeOrSpeed { Default, Neither, Size, Speed };
+
 	BuildSettings();
 	
 #if defined( CINDER_MSW )
-	//! Specifies a vcxproj to be parsed for compiler and linker settings. Will use the default project file if null.
+	//! Specifies a vcxproj to be parsed for compiler and linker settings, including the code generation settings of the project so that the runtime modules are optimized like the app. Will use the default project file if null.
 	BuildSettings& vcxproj( const ci::fs::path &path = ci::fs::path() );
 	//! Specifies a vcxproj to be parsed for compiler settings. Will use the default project file if null.
 	BuildSettings& vcxprojCpp( const ci::fs::path &path = ci::fs::path() );
 	//! Specifies a vcxproj to be parsed for linker settings. Will use the default project file if null.
 	BuildSettings& vcxprojLinker( const ci::fs::path &path = ci::fs::path() );
 #endif
+	//! Adds the include directories, definitions, language standard and code generation options of the command compiling sourcePath in a compilation database (compile_commands.json), or of another file of its directory if it has none. Will use the database of the build directory found by ProjectConfiguration if databasePath is empty.
+	BuildSettings& compileCommands( const ci::fs::path &sourcePath, const ci::fs::path &databasePath = ci::fs::path() );
 	
 	//! Adds an extra include folder to the compiler BuildSettings
 	BuildSettings& include( const ci::fs::path &path );
@@ -64,6 +79,8 @@ public:
 	BuildSettings& additionalSource( const ci::fs::path &cppFile );
 	//! Specifies additional files to be compiled (and linked).
 	BuildSettings& additionalSources( const std::vector<ci::fs::path> &cppFiles );
+	//! Specifies a file that includes the sources and additional sources and is compiled instead of them, as a single translation unit (unity build).
+	BuildSettings& unitySource( const ci::fs::path &cppFile );
 		
 	//! Specifies an object (.obj) file name or directory to be used instead of the default.
 	BuildSettings& objectFile( const ci::fs::path &path );
@@ -76,6 +93,8 @@ public:
 	BuildSettings& outputPath( const ci::fs::path &path );
 	//! Sets the intermediate directory path
 	BuildSettings& intermediatePath( const ci::fs::path &path );
+	//! Enables the build cache, stored in directory. Builds whose preprocessed sources and settings match a previous build reuse its output instead of compiling. The directory can be shared by several apps.
+	BuildSettings& cacheDirectory( const ci::fs::path &directory );
 		
 	//! Specifies the build configuration (Debug_Shared, Release_Shared, Release, Debug, etc...)
 	BuildSettings& configuration( const std::string &option );
@@ -106,10 +125,35 @@ public:
 
 	//! Enables verbose mode. Disabled by default.
 	BuildSettings& verbose( bool enabled = true );
+	//! Sets the maximum number of compiler jobs running at the same time for this build. Defaults to 0 which means as many as the compiler has workers.
+	BuildSettings& parallelJobs( size_t count );
+	//! Enables the compiler timing report (/Bt+ /d1reportTime for msvc, -ftime-trace for clang), collected in BuildOutput::getCompilerProfile. Disabled by default, not supported by gcc.
+	BuildSettings& compilerProfiling( bool enabled = true );
+	//! Sets the scheduling priority of the compiler and linker processes. Lower priorities keep the app frame time steady during builds, at the expense of build time when the app keeps the cpus busy. Defaults to Normal.
+	BuildSettings& jobPriority( Process::Priority priority );
+	//! Restricts the compiler and linker processes to the cpus whose bit is set in mask, ex. ~0x3ull leaves cpus 0 and 1 to the app. Defaults to 0 which allows every cpu.
+	BuildSettings& jobAffinity( uint64_t mask );
+
+	//! Sets the optimization level. Defaults to the compiler default, unoptimized for msvc and gcc. Unoptimized msvc builds enable the run-time error checks (/RTC1).
+	BuildSettings& optimization( Optimization level );
+	//! Enables the generation of intrinsic functions (/Oi). Disabled by default, gcc and clang always generate them when optimizing.
+	BuildSettings& intrinsicFunctions( bool enabled = true );
+	//! Sets which functions are considered for inlining. Defaults to the compiler default for the optimization level.
+	BuildSettings& inlineFunctionExpansion( InlineFunctionExpansion expansion );
+	//! Sets the instruction set extensions the generated code can use. Defaults to the compiler default for the platform. Ignored by gcc and clang on other cpus than x86.
+	BuildSettings& enhancedInstructionSet( InstructionSet instructionSet );
+	//! Sets the floating point model. Defaults to the compiler default.
+	BuildSettings& floatingPointModel( FloatingPointModel model );
+	//! Sets whether the optimizations favor the size or the speed of the code. Defaults to the compiler default.
+	BuildSettings& favorSizeOrSpeed( FavorSizeOrSpeed favor );
+
+	//! Makes the lists of settings share their storage with the equal lists of other interned settings. Meant for the settings kept for a long time, like the ones of watched types
+	BuildSettings& intern();
 
 	const ci::fs::path& 	getPrecompiledHeader() const { return mPrecompiledHeader; }
 	const ci::fs::path& 	getOutputPath() const { return mOutputPath; }
 	const ci::fs::path& 	getIntermediatePath() const { return mIntermediatePath; }
+	const ci::fs::path& 	getCacheDirectory() const { return mCacheDirectory; }
 	const ci::fs::path& 	getObjectFilePath() const { return mObjectFilePath; }
 	const ci::fs::path& 	getPdbPath() const { return mPdbPath; }
 	const ci::fs::path& 	getPdbAltPath() const { return mPdbAltPath; }
@@ -121,6 +165,7 @@ public:
 	const std::vector<ci::fs::path>& 	getIncludes() const { return mIncludes; }
 	const std::vector<ci::fs::path>& 	getLibraryPaths() const { return mLibraryPaths; }
 	const std::vector<ci::fs::path>& 	getAdditionalSources() const { return mAdditionalSources; }
+	const ci::fs::path& 				getUnitySource() const { return mUnitySource; }
 	const std::vector<std::string>& 	getLibraries() const { return mLibraries; }
 	const std::vector<std::string>& 	getPpDefinitions() const { return mPpDefinitions; }
 	const std::vector<std::string>& 	getForcedIncludes() const { return mForcedIncludes; }
@@ -131,18 +176,41 @@ public:
 	const std::map<std::string, std::string>&	getUserMacros() const	{ return mUserMacros; };
 
 	bool isVerboseEnabled() const	{ return mVerbose; }
+	bool isCompilerProfilingEnabled() const	{ return mCompilerProfiling; }
+	size_t getNumParallelJobs() const	{ return mNumParallelJobs; }
+	Process::Priority getJobPriority() const	{ return mJobPriority; }
+	uint64_t getJobAffinity() const	{ return mJobAffinity; }
+	Optimization getOptimization() const	{ return mOptimization; }
+	bool isIntrinsicFunctionsEnabled() const	{ return mIntrinsicFunctions; }
+	InlineFunctionExpansion getInlineFunctionExpansion() const	{ return mInlineFunctionExpansion; }
+	InstructionSet getEnhancedInstructionSet() const	{ return mEnhancedInstructionSet; }
+	FloatingPointModel getFloatingPointModel() const	{ return mFloatingPointModel; }
+	FavorSizeOrSpeed getFavorSizeOrSpeed() const	{ return mFavorSizeOrSpeed; }
 
 	//! Method meant for debugging purposes to write a pretty string of all settings
 	std::string printToString() const;
 
 protected:
+	friend class CompilerBase;
 	friend class CompilerMsvc;
+	friend class CompilerGcc;
 	bool mVerbose;
+	bool mCompilerProfiling;
 	bool mCreatePch;
 	bool mUsePch;
+	size_t mNumParallelJobs;
+	Process::Priority mJobPriority;
+	uint64_t mJobAffinity;
+	Optimization mOptimization;
+	bool mIntrinsicFunctions;
+	InlineFunctionExpansion mInlineFunctionExpansion;
+	InstructionSet mEnhancedInstructionSet;
+	FloatingPointModel mFloatingPointModel;
+	FavorSizeOrSpeed mFavorSizeOrSpeed;
 	ci::fs::path mPrecompiledHeader;
 	ci::fs::path mOutputPath;
 	ci::fs::path mIntermediatePath;
+	ci::fs::path mCacheDirectory;
 	ci::fs::path mObjectFilePath;
 	ci::fs::path mPdbPath;
 	ci::fs::path mPdbAltPath;
@@ -151,19 +219,20 @@ protected:
 	std::string	mPlatform;
 	std::string	mPlatformToolset;
 	std::string mModuleName;
-	std::vector<ci::fs::path> mIncludes;
-	std::vector<ci::fs::path> mLibraryPaths;
-	std::vector<ci::fs::path> mAdditionalSources;
-	std::vector<std::string> mLibraries;
-	std::vector<std::string> mPpDefinitions;
-	std::vector<std::string> mForcedIncludes;
-	std::vector<std::string> mCompilerOptions;
-	std::vector<std::string> mLinkerOptions;
-	std::vector<ci::fs::path> mObjPaths;
-	std::map<std::string, std::string>	mUserMacros;
+	CopyOnWrite<std::vector<ci::fs::path>> mIncludes;
+	CopyOnWrite<std::vector<ci::fs::path>> mLibraryPaths;
+	CopyOnWrite<std::vector<ci::fs::path>> mAdditionalSources;
+	ci::fs::path mUnitySource;
+	CopyOnWrite<std::vector<std::string>> mLibraries;
+	CopyOnWrite<std::vector<std::string>> mPpDefinitions;
+	CopyOnWrite<std::vector<std::string>> mForcedIncludes;
+	CopyOnWrite<std::vector<std::string>> mCompilerOptions;
+	CopyOnWrite<std::vector<std::string>> mLinkerOptions;
+	CopyOnWrite<std::vector<ci::fs::path>> mObjPaths;
+	CopyOnWrite<std::map<std::string, std::string>>	mUserMacros;
 	
-	std::vector<BuildStepRef> mPreBuildSteps;
-	std::vector<BuildStepRef> mPostBuildSteps;
+	CopyOnWrite<std::vector<BuildStepRef>> mPreBuildSteps;
+	CopyOnWrite<std::vector<BuildStepRef>> mPostBuildSteps;
 };
 
 } // namespace runtime
@@ -54,17 +54,23 @@ public:
 		Options& placementNewOperator( const std::string &className );
 		//! Adds an include at the top of the source
 		Options& include( const std::string &filename );
+		//! Includes the source at path in the generated source, which becomes the only translation unit of the module along with the additional sources it then includes (unity build)
+		Options& unitySource( const ci::fs::path &path );
 
 	protected:
 		friend class CodeGeneration;
 		std::vector<std::string> mNewOperators;
 		std::vector<std::string> mPlacementNewOperators;
 		std::vector<std::string> mIncludes;
+		std::vector<ci::fs::path> mUnitySources;
 	};
 
 	CodeGeneration( const Options &options );
 	void execute( BuildSettings* settings ) const override;
 protected:
+	//! Writes the factory source, including sources after the headers
+	void generateSource( std::ostream &stream, const BuildSettings &settings, const std::vector<ci::fs::path> &sources ) const;
+
 	Options mOptions;
 };
 
@@ -119,6 +125,15 @@ public:
 protected:
 };
 
+//! BuildStep used to resolve the app symbols against the running executable instead of linking the app's .obj files again. On Windows the app 
+//! exports its symbols (__declspec(dllexport), /EXPORT or a .def file) and the module links the import library the linker writes next to the 
+//! executable, or one generated from the exports with lib.exe. On Linux the app is linked with -rdynamic. Falls back to LinkAppObjs otherwise
+class CI_RT_API LinkAppExports : public BuildStep {
+public:
+	void execute( BuildSettings* settings ) const override;
+protected:
+};
+
 class CI_RT_API CopyBuildOutput : public BuildStep {
 public:
 	void execute( BuildSettings* settings ) const override;
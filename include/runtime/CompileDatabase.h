@@ -0,0 +1,94 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "runtime/Export.h"
+#include "cinder/Exception.h"
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+using CompileDatabaseRef = std::shared_ptr<class CompileDatabase>;
+
+//! Compilation database (compile_commands.json) as generated by CMake. The file is memory mapped and indexed by source file 
+//! in a single pass when loaded, finding the command of a file then only parses the entry of that file. The entries indexed are
+//! copied out and the file unmapped before the constructor returns, build tools are free to rewrite it in place
+class CI_RT_API CompileDatabase {
+public:
+	//! Command compiling a file of the database
+	struct Command {
+		//! Working directory of the command, the relative paths of the arguments are relative to it
+		ci::fs::path				mDirectory;
+		ci::fs::path				mFile;
+		//! Arguments of the command, starting with the compiler
+		std::vector<std::string>	mArguments;
+	};
+
+	//! Loads the database at path. Throws a CompileDatabaseException if the file can't be read or isn't a compilation database
+	explicit CompileDatabase( const ci::fs::path &path );
+	~CompileDatabase();
+
+	CompileDatabase( const CompileDatabase & ) = delete;
+	CompileDatabase& operator=( const CompileDatabase & ) = delete;
+
+	//! Returns the database at path, shared with the previous calls until the file changes
+	static CompileDatabaseRef load( const ci::fs::path &path );
+
+	//! Finds the command compiling file. Falls back to the command of another file of the same directory when file has none, as for a source added since the database was generated. Returns false if there's none
+	bool findCommand( const ci::fs::path &file, Command* command ) const;
+	//! Returns the number of commands in the database
+	size_t getNumCommands() const { return mIndex.size(); }
+	//! Returns the path of the database
+	const ci::fs::path& getPath() const { return mPath; }
+
+protected:
+	//! Byte range of an entry in mEntries
+	struct Entry {
+		size_t mBegin;
+		size_t mEnd;
+	};
+
+	//! Returns the entry of file, looking it up by path then by directory
+	const Entry* findEntry( const ci::fs::path &file ) const;
+	//! Parses the entry at offset begin
+	void readCommand( size_t begin, Command* command ) const;
+
+	ci::fs::path	mPath;
+	//! Text of the entries indexed, in the order of the file
+	std::string		mEntries;
+	//! Entries indexed by the normalized absolute path of their file, and by the directory of their file
+	std::unordered_map<std::string, Entry>	mIndex;
+	std::unordered_map<std::string, Entry>	mDirectoryIndex;
+};
+
+class CI_RT_API CompileDatabaseException : public ci::Exception {
+public:
+	CompileDatabaseException( const std::string &message ) : ci::Exception( message ) {}
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -0,0 +1,49 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#if defined( CINDER_MSW )
+	#include "runtime/CompilerMsvc.h"
+#elif defined( CINDER_RT_EXPERIMENTAL_CLANG_JIT )
+	#include "runtime/CompilerClangJit.h"
+#else
+	#include "runtime/CompilerGcc.h"
+#endif
+
+namespace runtime {
+
+//! Compiler used by default on this platform. Defining CINDER_RT_COMPILER_CLANG selects Clang over GCC. Defining CINDER_RT_EXPERIMENTAL_CLANG_JIT selects 
+//! the experimental CompilerClangJit, which only links and loads the modules in memory with the ORC JIT. The Clang driver still compiles them out of process.
+#if defined( CINDER_MSW )
+using Compiler = class CompilerMsvc;
+#elif defined( CINDER_RT_EXPERIMENTAL_CLANG_JIT )
+using Compiler = class CompilerClangJit;
+#elif defined( CINDER_RT_COMPILER_CLANG ) || defined( CINDER_MAC )
+using Compiler = class CompilerClang;
+#else
+using Compiler = class CompilerGcc;
+#endif
+using CompilerRef = std::shared_ptr<Compiler>;
+using CompilerPtr = std::unique_ptr<Compiler>;
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -22,12 +22,19 @@
 
 #include <memory>
 #include <functional>
+#include <future>
+#include <map>
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <string_view>
 
 #include "cinder/Exception.h"
 #include "cinder/Filesystem.h"
 #include "cinder/signals.h"
 
 #include "runtime/BuildOutput.h"
+#include "runtime/Hash.h"
 
 using ProcessPtr = std::unique_ptr<class Process>;
 
@@ -40,23 +47,180 @@ public:
 	CompilerBase();
 	virtual ~CompilerBase();
 	
-	//! Compiles and links the file at path. A callback can be specified to get the compilation results.
-	virtual void build( const std::string &arguments, const std::function<void(const BuildOutput&)> &onBuildFinish = nullptr ) {}
+	//! Unique identifier of a build, shared by all the jobs issued for it
+	using BuildId = uint64_t;
+
+	//! Single compiler or linker invocation running in its own process
+	class CI_RT_API Job {
+	public:
+		//! Returns the build this job belongs to
+		BuildId getBuildId() const { return mBuildId; }
+		//! Returns the arguments the job has been started with
+		const std::vector<std::string>& getArguments() const { return mArguments; }
+		//! Returns the exit code of the process, or -1 if it's still running
+		int getExitCode() const { return mExitCode; }
+		//! Returns whether the process exited with a zero exit code
+		bool succeeded() const { return mExitCode == 0; }
+		//! Returns the errors found in the job output
+		const std::vector<std::string>& getErrors() const { return mErrors; }
+		//! Returns the warnings found in the job output
+		const std::vector<std::string>& getWarnings() const { return mWarnings; }
+		//! Returns the errors, warnings and notes found in the job output
+		const std::vector<Diagnostic>& getDiagnostics() const { return mDiagnostics; }
+		//! Returns the headers the compiler reported in the job output
+		const std::vector<ci::fs::path>& getDependencies() const { return mDependencies; }
+		//! Returns the timings the compiler reported in the job output
+		const CompilerProfile& getProfile() const { return mProfile; }
+		//! Returns the hash of the standard output of the job, only computed for the jobs started with hashOutput
+		uint64_t getOutputHash() const { return mOutputHash.getValue(); }
+		//! Returns the time between the start of the process and the end of its output
+		std::chrono::steady_clock::duration getDuration() const { return mDuration; }
+
+		Job( BuildId buildId, const std::vector<std::string> &arguments, const std::function<void(const Job&)> &onFinish );
+		~Job();
+	protected:
+		friend class CompilerBase;
+		BuildId								mBuildId;
+		std::vector<std::string>			mArguments;
+		int									mExitCode;
+		std::vector<std::string>			mErrors;
+		std::vector<std::string>			mWarnings;
+		std::vector<Diagnostic>				mDiagnostics;
+		std::vector<ci::fs::path>			mDependencies;
+		CompilerProfile						mProfile;
+		bool								mHashOutput;
+		Hash								mOutputHash;
+		std::chrono::steady_clock::time_point	mStartTime;
+		std::chrono::steady_clock::duration		mDuration;
+		std::function<void(const Job&)>		mOnFinish;
+		ProcessPtr							mProcess;
+	};
+	
+	//! Executes a command line in the compiler environment. A callback can be specified to get the build results.
+	BuildId build( const std::string &arguments, const std::function<void(const BuildOutput&)> &onBuildFinish = nullptr );
+	//! Compiles and links the file at sourcePath. A callback can be specified to get the compilation results.
+	BuildId build( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::function<void(const BuildOutput&)> &onBuildFinish = nullptr );
+	//! Compiles and links the files at sourcesPaths in a single module. A callback can be specified to get the compilation results.
+	BuildId build( const std::vector<ci::fs::path> &sourcesPaths, const BuildSettings &settings, const std::function<void(const BuildOutput&)> &onBuildFinish = nullptr );
+	//! Executes the pre build steps of settings and generates the precompiled header they ask for, without compiling nor linking, so that the files reused by the next builds exist before the first one. Returns 0 without calling onBuildFinish if there's nothing to generate.
+	BuildId prebuild( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::function<void(const BuildOutput&)> &onBuildFinish = nullptr );
+	//! Stops a build, killing its jobs in flight. Its callback won't be called. Does nothing if the build already finished
+	void cancel( BuildId buildId );
+	//! Returns whether a build is still in progress
+	bool isBuilding( BuildId buildId ) const { return mBuilds.count( buildId ) > 0; }
+
+	//! Method meant for debugging purposes to write a pretty string of all settings
+	virtual std::string printToString() const = 0;
+	//! This logs the Compiler and BuildSettings to ci::log
+	virtual void debugLog( BuildSettings *settings = nullptr ) const;
+
+	//! Returns the environment the compiler and linker are executed with as a list of NAME=VALUE strings. Blocks until it has been captured.
+	const std::vector<std::string>& getEnvironment() const;
+	//! Returns the full path of an executable found in the PATH of the compiler environment
+	ci::fs::path findExecutable( const std::string &name ) const;
+
+	//! Sets the number of compiler and linker processes that can run at the same time, across all builds. Defaults to one per hardware thread.
+	void setNumWorkers( size_t numWorkers );
+	//! Returns the number of compiler and linker processes that can run at the same time, across all builds
+	size_t getNumWorkers() const { return mNumWorkers; }
 	
 protected:
-	virtual std::string		getCLInitCommand() const = 0;
-	virtual ci::fs::path	getCLInitPath() const = 0;
-	virtual ci::fs::path	getCompilerPath() const = 0;
-	virtual std::string		getCompilerInitArgs() const = 0;
+	//! Returns the arguments of the job generating the precompiled header
+	virtual std::vector<std::string> generatePrecompiledHeaderArgs( const BuildSettings &settings, BuildOutput* output ) const = 0;
+	//! Returns the arguments of the job compiling the single translation unit at sourcePath. Adds its object file to output
+	virtual std::vector<std::string> generateCompilerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const = 0;
+	//! Returns the arguments of the job writing the preprocessed translation unit at sourcePath to the standard output, without line directives
+	virtual std::vector<std::string> generatePreprocessorArgs( const ci::fs::path &sourcePath, const BuildSettings &settings ) const = 0;
+	//! Returns the arguments of the job linking the object files of output into a module. Sets the output path. No job is started if empty
+	virtual std::vector<std::string> generateLinkerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const = 0;
+	//! Called once all the jobs of a build succeeded, before its post build steps. Returns false if the build failed, with the errors added to output
+	virtual bool finalizeOutput( BuildOutput* output ) { return true; }
+	//! Returns a short description of what is being built for the build logs
+	virtual std::string getBuildDescription() const = 0;
+
+	//! Returns the directory the jobs are started in
+	virtual ci::fs::path	getWorkingDirectory() const = 0;
+	//! Returns the environment of the compiler and linker. Defaults to the environment of the app. Called once from a separate thread
+	virtual std::vector<std::string> captureEnvironment() const;
+
+	//! Starts capturing the environment in the background and connects the jobs to the app update loop
+	void initializeJobs();
+	//! Returns a new unique build id
+	BuildId generateBuildId();
+	//! Executes args directly, with args[0] looked up in the compiler environment. onFinish is called from the app update loop once the process exited and all its output has been parsed. If hashOutput is true the standard output is hashed instead of parsed
+	void startJob( BuildId buildId, const std::vector<std::string> &args, const std::function<void(const Job&)> &onFinish, bool hashOutput = false );
+	//! Executes a command line through the system shell. onFinish is called from the app update loop once the process exited and all its output has been parsed
+	void startShellJob( BuildId buildId, const std::string &commandLine, const std::function<void(const Job&)> &onFinish );
+	//! Kills the jobs in flight for buildId without calling their callbacks
+	void cancelJobs( BuildId buildId );
+	//! Returns the number of jobs in flight
+	size_t getNumJobs() const { return mJobs.size(); }
+	//! Called for each line of a job output. Adds the diagnostics found to the job
+	virtual void parseJobOutput( Job* job, std::string_view line );
+	//! Returns whether a line of a job output reports a header included by the job, in which case it isn't parsed further. header is left empty for the headers that aren't tracked (ex. system headers)
+	virtual bool parseDependency( std::string_view line, ci::fs::path* header ) const { return false; }
+	//! Returns the headers included by a job that succeeded, for the compilers writing them to a file rather than to the output
+	virtual std::vector<ci::fs::path> readDependencies( const Job &job ) const { return {}; }
+	//! Returns whether a line of a job output is part of the compiler timing report, in which case it's added to profile and isn't parsed further
+	virtual bool parseProfile( std::string_view line, CompilerProfile* profile ) const { return false; }
+	//! Adds the timings of a job that succeeded to profile, for the compilers writing them to a file rather than to the output. Only called when profiling is enabled
+	virtual void readProfile( const Job &job, CompilerProfile* profile ) const {}
+	//! Parses the output of the jobs in flight and finishes the ones that exited
+	void updateJobs();
+
+	//! Node of the graph of jobs of a build. A task is ready to start once all its dependencies finished
+	struct Task {
+		std::string								mName;
+		std::vector<std::string>				mArguments;
+		std::vector<size_t>						mDependents;
+		size_t									mNumDependencies;
+		//! Whether the task preprocesses a translation unit for the cache key, and the hash of its output
+		bool									mPreprocessor;
+		uint64_t								mOutputHash;
+	};
+
+	struct Build {
+		BuildOutput								mOutput;
+		std::function<void(const BuildOutput&)>	mCallback;
+		std::vector<Task>						mTasks;
+		//! Indices of the tasks whose dependencies all finished, in the order they became ready
+		std::deque<size_t>						mReadyTasks;
+		size_t									mNumRunningJobs;
+		size_t									mNumFinishedTasks;
+		//! Maximum number of jobs of this build running at the same time, 0 if only limited by the number of workers
+		size_t									mMaxJobs;
+		bool									mFailed;
+		size_t									mNumPreprocessorTasks;
+		//! Key of the build in the cache, empty until all the translation units have been preprocessed
+		std::string								mCacheKey;
+		//! Whether the build output has been found in the cache, in which case only the jobs in flight are waited for
+		bool									mCached;
+		//! Whether the build only generates the precompiled header, in which case there's no module to finalize
+		bool									mPrebuild;
+	};
 
-	virtual void parseProcessOutput();
-	void initializeProcess();
+	//! Adds a task to build that starts once the tasks at indices dependencies finished. Returns the index of the new task
+	size_t addTask( Build* build, const std::string &name, const std::vector<std::string> &args, const std::vector<size_t> &dependencies = {} );
+	//! Returns the key of a build in the cache, from its preprocessed translation units, its settings and the identity of the tools
+	std::string generateCacheKey( const Build &build ) const;
+	//! Copies the output of a build from the cache. Returns false if the cache doesn't have it
+	bool fetchFromCache( Build* build );
+	//! Starts ready tasks until all the workers are busy, taking turns between the builds so that concurrent builds progress together
+	void dispatchTasks();
+	//! Called when the job of one of the tasks of a build exited
+	void taskFinished( BuildId buildId, size_t taskIndex, const Job &job );
+	//! Reports the build results and calls its callback on success
+	void buildFinished( BuildId buildId );
 
-	ProcessPtr								mProcess;
-	ci::signals::ScopedConnection			mProcessOutputConnection;
+	std::map<BuildId,Build>					mBuilds;
+	std::vector<std::unique_ptr<Job>>		mJobs;
+	BuildId									mNextBuildId;
+	BuildId									mLastDispatchedBuildId;
+	size_t									mNumWorkers;
+	std::shared_future<std::vector<std::string>> mEnvironment;
+	mutable std::map<std::string,ci::fs::path> mExecutables;
+	ci::signals::ScopedConnection			mUpdateConnection;
 	bool									mVerbose;
-	std::vector<std::string>				mErrors;
-	std::vector<std::string>				mWarnings;
 };
 
 class CI_RT_API CompilerException : public ci::Exception {
@@ -0,0 +1,68 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "runtime/CompilerGcc.h"
+
+#if defined( CINDER_RT_EXPERIMENTAL_CLANG_JIT )
+
+namespace llvm { namespace orc {
+	class LLJIT;
+} } // namespace llvm::orc
+
+namespace runtime {
+
+using CompilerClangJitRef = std::shared_ptr<class CompilerClangJit>;
+using CompilerClangJitPtr = std::unique_ptr<class CompilerClangJit>;
+
+//! Experimental ORC loader for Clang builds. The Clang driver still compiles every translation unit out of process, like CompilerClang,
+//! but to LLVM bitcode, and the LLVM ORC JIT links the result in the app process instead of the system linker. There's no shared library to
+//! write, copy and load: the module symbols are resolved by BuildOutput::getSymbolLookup(), and the code of a version is released with the
+//! last copy of its lookup. Only the link and load steps are saved, there's no in-process frontend and no preamble kept between builds, so
+//! compiling takes as long as with CompilerClang. Requires defining CINDER_RT_EXPERIMENTAL_CLANG_JIT and linking against LLVM
+class CI_RT_API CompilerClangJit : public CompilerClang {
+public:
+	CompilerClangJit();
+	~CompilerClangJit();
+
+	static CompilerClangJit& instance();
+
+	//! Method meant for debugging purposes to write a pretty string of all settings
+	std::string printToString() const override;
+
+protected:
+	std::vector<std::string> generateCompilerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const override;
+	std::vector<std::string> generateLinkerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const override;
+	std::string getBuildDescription() const override;
+	//! Links the bitcode and object files of output in a new JITDylib and runs its static initializers
+	bool finalizeOutput( BuildOutput* output ) override;
+
+	//! Shared with the symbol lookups of the modules, which can outlive the compiler
+	std::shared_ptr<llvm::orc::LLJIT>	mJit;
+	size_t								mNumModules;
+	std::vector<std::string>			mSessionErrors;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "runtime/CompilerBase.h"
+#include "runtime/BuildSettings.h"
+
+namespace runtime {
+
+using CompilerGccRef = std::shared_ptr<class CompilerGcc>;
+using CompilerGccPtr = std::unique_ptr<class CompilerGcc>;
+using CompilerClangRef = std::shared_ptr<class CompilerClang>;
+using CompilerClangPtr = std::unique_ptr<class CompilerClang>;
+
+//! Builds runtime modules as shared objects with the GCC driver
+class CI_RT_API CompilerGcc : public CompilerBase {
+public:
+	CompilerGcc();
+	~CompilerGcc();
+
+	static CompilerGcc& instance();
+
+	//! Method meant for debugging purposes to write a pretty string of all settings
+	std::string printToString() const override;
+
+protected:
+	std::vector<std::string> generatePrecompiledHeaderArgs( const BuildSettings &settings, BuildOutput* output ) const override;
+	std::vector<std::string> generateCompilerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const override;
+	std::vector<std::string> generatePreprocessorArgs( const ci::fs::path &sourcePath, const BuildSettings &settings ) const override;
+	std::vector<std::string> generateLinkerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const override;
+	std::vector<ci::fs::path> readDependencies( const Job &job ) const override;
+	std::string getBuildDescription() const override;
+
+	ci::fs::path	getWorkingDirectory() const override;
+	//! Returns the name of the compiler driver, used for compiling and linking
+	virtual std::string getDriver() const;
+
+	//! Returns the flags shared by the precompiled header and the sources, which need to match for the precompiled header to be used
+	std::vector<std::string> generateCommonArgs( const BuildSettings &settings ) const;
+};
+
+//! Builds runtime modules as shared objects with the Clang driver
+class CI_RT_API CompilerClang : public CompilerGcc {
+public:
+	static CompilerClang& instance();
+
+protected:
+	std::string getDriver() const override;
+	std::vector<std::string> generatePrecompiledHeaderArgs( const BuildSettings &settings, BuildOutput* output ) const override;
+	std::vector<std::string> generateCompilerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const override;
+	//! Reads the trace -ftime-trace writes next to the object file
+	void readProfile( const Job &job, CompilerProfile* profile ) const override;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -0,0 +1,80 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "runtime/CompilerBase.h"
+#include "runtime/BuildSettings.h"
+
+#include <map>
+#include <mutex>
+
+namespace runtime {
+
+using CompilerMsvcRef = std::shared_ptr<class CompilerMsvc>;
+using CompilerMsvcPtr = std::unique_ptr<class CompilerMsvc>;
+
+class CI_RT_API CompilerMsvc : public CompilerBase {
+public:
+	CompilerMsvc();
+	~CompilerMsvc();
+
+	static CompilerMsvc& instance();
+	
+	//! Returns the compiler-decorated symbol of typeName's vtable.
+	std::string	getSymbolForVTable( const std::string &typeName ) const;
+
+	//! Method meant for debugging purposes to write a pretty string of all settings
+	std::string printToString() const override;
+	//! This logs Compiler, ProjectConfiguration, and BuildSettings to ci::log
+	void debugLog( BuildSettings *settings = nullptr ) const override;
+
+protected:
+	std::vector<std::string> generatePrecompiledHeaderArgs( const BuildSettings &settings, BuildOutput* output ) const override;
+	std::vector<std::string> generateCompilerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const override;
+	std::vector<std::string> generatePreprocessorArgs( const ci::fs::path &sourcePath, const BuildSettings &settings ) const override;
+	std::vector<std::string> generateLinkerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const override;
+	std::string getBuildDescription() const override;
+	//! Parses the headers reported by /showIncludes
+	bool parseDependency( std::string_view line, ci::fs::path* header ) const override;
+	//! Parses the /Bt+ and /d1reportTime report
+	bool parseProfile( std::string_view line, CompilerProfile* profile ) const override;
+	//! Returns whether path is under one of the directories of the INCLUDE environment variable
+	bool isSystemHeader( std::string_view path ) const;
+	//! Returns the "@file" argument of the response file holding the defines, includes, forced includes and compiler options of settings
+	std::string getCompilerResponseFile( const BuildSettings &settings ) const;
+	//! Returns the "@file" argument of the response file holding the library paths, libraries and linker options of settings
+	std::string getLinkerResponseFile( const BuildSettings &settings ) const;
+	//! Returns the "@file" argument of a response file holding the arguments returned by generateArgs, only called the first time fingerprint is seen
+	std::string getResponseFile( const std::string &name, uint64_t fingerprint, const BuildSettings &settings, const std::function<std::vector<std::string>()> &generateArgs ) const;
+
+	std::vector<std::string> captureEnvironment() const override;
+	ci::fs::path	getWorkingDirectory() const override;
+	ci::fs::path	getVcvarsallPath() const;
+	std::string		getVcvarsallArgs() const;
+
+	mutable std::unique_ptr<std::vector<std::string>>	mSystemIncludeDirs;
+	mutable std::map<uint64_t,std::string>				mResponseFiles;
+	mutable std::mutex									mResponseFilesMutex;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
\ No newline at end of file
@@ -0,0 +1,88 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <chrono>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "runtime/Export.h"
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+//! Time the compiler reported spending on its phases, headers and definitions, aggregated across translation units and builds
+class CI_RT_API CompilerProfile {
+public:
+	enum class Category {
+		//! Compiler passes, ex. "c1xx" and "c2" for msvc, "Frontend" and "Backend" for clang
+		Phase,
+		//! Headers, including the time spent on the headers they include
+		Header,
+		//! Class and function definitions, template instantiations included
+		Instantiation
+	};
+
+	//! Accumulated cost of a phase, header or definition
+	struct Entry {
+		std::string					mName;
+		std::chrono::microseconds	mDuration;
+		size_t						mCount;
+	};
+
+	CompilerProfile();
+
+	//! Adds duration to the entry name of category
+	void add( Category category, const std::string &name, std::chrono::microseconds duration );
+	//! Adds the entries of other to this profile
+	void merge( const CompilerProfile &other );
+	//! Removes all the entries
+	void clear();
+	//! Returns whether nothing has been recorded
+	bool isEmpty() const;
+
+	//! Returns the entries of category, the most expensive first
+	std::vector<Entry> getEntries( Category category, size_t maxEntries = std::numeric_limits<size_t>::max() ) const;
+	//! Returns a report of the maxEntries most expensive entries of each category
+	std::string printToString( size_t maxEntries = 10 ) const;
+
+	//! Parses a line of the msvc /Bt+ or /d1reportTime output. Returns false if the line isn't part of the report
+	bool parseReportTimeLine( std::string_view line );
+	//! Reads the json trace written by clang -ftime-trace. Returns false if the file can't be read or is malformed, keeping the events read until the error
+	bool readTimeTrace( const ci::fs::path &path );
+
+protected:
+	std::map<std::string,Entry>& getCategory( Category category );
+	const std::map<std::string,Entry>& getCategory( Category category ) const;
+
+	std::map<std::string,Entry>	mPhases;
+	std::map<std::string,Entry>	mHeaders;
+	std::map<std::string,Entry>	mInstantiations;
+	//! Section of the /d1reportTime output being parsed
+	std::string					mReportSection;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -0,0 +1,70 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <memory>
+
+namespace runtime {
+
+//! Value shared by its copies until one of them is modified, copying it only copies a pointer
+template<typename T>
+class CopyOnWrite {
+public:
+	CopyOnWrite() = default;
+
+	//! Returns the value
+	const T& get() const { return mValue ? *mValue : getEmpty(); }
+	operator const T&() const { return get(); }
+	//! Returns the value to be modified, copied first if it is shared with other instances
+	T& modify();
+
+	//! Returns the storage of the value, null while the value is empty
+	const std::shared_ptr<const T>& getShared() const { return mValue; }
+	//! Replaces the value by the storage of another instance
+	void share( const std::shared_ptr<const T> &value ) { mValue = value; }
+
+	typename T::const_iterator begin() const { return get().begin(); }
+	typename T::const_iterator end() const { return get().end(); }
+	size_t size() const { return get().size(); }
+	bool empty() const { return get().empty(); }
+
+protected:
+	static const T& getEmpty() { static const T empty; return empty; }
+
+	std::shared_ptr<const T> mValue;
+};
+
+template<typename T>
+T& CopyOnWrite<T>::modify()
+{
+	// a use count of 1 can't grow concurrently, that would require copying this instance while it's being modified
+	if( ! mValue ) {
+		mValue = std::make_shared<T>();
+	}
+	else if( mValue.use_count() > 1 ) {
+		mValue = std::make_shared<T>( *mValue );
+	}
+	return const_cast<T&>( *mValue );
+}
+
+} // namespace runtime
+
+namespace rt = runtime;
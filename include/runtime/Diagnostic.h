@@ -0,0 +1,70 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "runtime/Export.h"
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+//! Single error, warning or note reported by the compiler or the linker
+class CI_RT_API Diagnostic {
+public:
+	enum class Severity { Note, Warning, Error, FatalError };
+
+	Diagnostic();
+	Diagnostic( Severity severity, const ci::fs::path &file, int line, int column, const std::string &code, const std::string &message );
+
+	//! Parses a line of MSVC, GCC, Clang or linker output. Returns false if the line isn't a diagnostic
+	static bool parse( std::string_view line, Diagnostic* diagnostic );
+
+	//! Returns the severity of the diagnostic
+	Severity getSeverity() const { return mSeverity; }
+	//! Returns whether the diagnostic is an error or a fatal error
+	bool isError() const { return mSeverity == Severity::Error || mSeverity == Severity::FatalError; }
+	//! Returns whether the diagnostic is a warning
+	bool isWarning() const { return mSeverity == Severity::Warning; }
+	//! Returns the file the diagnostic refers to, or the tool that reported it when there's no file (ex. LINK)
+	const ci::fs::path& getFile() const { return mFile; }
+	//! Returns the line the diagnostic refers to, or 0 if unknown
+	int getLine() const { return mLine; }
+	//! Returns the column the diagnostic refers to, or 0 if unknown
+	int getColumn() const { return mColumn; }
+	//! Returns the diagnostic code (ex. C2065, LNK2019 or -Wunused-variable), or an empty string if there's none
+	const std::string& getCode() const { return mCode; }
+	//! Returns the diagnostic message
+	const std::string& getMessage() const { return mMessage; }
+
+protected:
+	Severity		mSeverity;
+	ci::fs::path	mFile;
+	int				mLine;
+	int				mColumn;
+	std::string		mCode;
+	std::string		mMessage;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -20,7 +20,7 @@
 */
 /*
 TODO:
-	[ ] include Class.cpp in ClassFactory.cpp and only build the later
+	[x] include Class.cpp in ClassFactory.cpp and only build the later (TypeFormat::unityBuild)
 	[ ] change module name / type name / target name?
 	[ ] cache module fn ptrs to Type std::functions
 	[ ] Factory::Notification
@@ -31,6 +31,9 @@ TODO:
 #pragma once
 
 #include <typeindex>
+#include <chrono>
+#include <set>
+#include <deque>
 
 #include "cinder/Exception.h"
 #include "cinder/Filesystem.h"
@@ -39,7 +42,8 @@ TODO:
 
 #include "runtime/Export.h"
 #include "runtime/Module.h"
-#include "runtime/CompilerMsvc.h"
+#include "runtime/Compiler.h"
+#include "runtime/CompilerProfile.h"
 
 // If cereal is included before this file any serialization methods
 // added to a class will be used to save states between reloads
@@ -72,7 +76,7 @@ public:
 	//! TypeFormat allows to opt-in or out from code generation and symbol exports
 	class CI_RT_API TypeFormat {
 	public:
-		TypeFormat() : mPrecompiledHeader( true ), mClassFactory( true ), mExportVftable( true ), mLinkAppObjs( true ) {}
+		TypeFormat() : mPrecompiledHeader( true ), mClassFactory( true ), mExportVftable( true ), mLinkAppObjs( true ), mLinkAppExports( false ), mUnityBuild( false ), mPrebuild( false ) {}
 		//! Adds a pre-build step to generate the precompiled header sources and build settings
 		TypeFormat& precompiledHeader( bool generate = true );
 		//! Adds a pre-build step to generate the class factory sources and build settings
@@ -81,12 +85,21 @@ public:
 		TypeFormat& exportVftable( bool exportSymbol = true );
 		//! Adds the app's generated .obj files to be linked. Default to true
 		TypeFormat& linkAppObjs( bool link );
+		//! Resolves the app symbols against the running executable, which needs to export them (see LinkAppExports), instead of linking the app's .obj files. Takes precedence over linkAppObjs. Default to false
+		TypeFormat& linkAppExports( bool link = true );
+		//! Makes the generated class factory include the type sources so that the module is compiled as a single translation unit. Requires the class factory. Default to false
+		TypeFormat& unityBuild( bool enable = true );
+		//! Generates the class factory, module definition and precompiled header in the background once the type is watched, instead of on its first build. Limited by Factory::setMaxPrebuilds. Default to false
+		TypeFormat& prebuild( bool enable = true );
 	protected:
 		friend class Factory;
 		bool mPrecompiledHeader;
 		bool mClassFactory;
 		bool mExportVftable;
 		bool mLinkAppObjs;
+		bool mLinkAppExports;
+		bool mUnityBuild;
+		bool mPrebuild;
 	};
 
 	//! Allocates a new instance and adds it to the Factory watch list
@@ -96,11 +109,17 @@ public:
 	template<class Class>
 	void* allocateAndWatch( const std::string &className, const ci::fs::path &cppPath, const ci::fs::path &headerPath, rt::BuildSettings* settings, const TypeFormat &format = TypeFormat() );
 	
+	//! Adds an instance to the Factory watch list, built with the getDefaultBuildSettings() of its first file
+	template<typename T>
+	void watch( void* address, const std::string &className, const std::vector<ci::fs::path> &filePaths );
 	//! Adds an instance to the Factory watch list
 	template<typename T>
-	void watch( void* address, const std::string &className, const std::vector<ci::fs::path> &filePaths, const rt::BuildSettings &settings = rt::BuildSettings().vcxproj(), const TypeFormat &format = TypeFormat() );
+	void watch( void* address, const std::string &className, const std::vector<ci::fs::path> &filePaths, const rt::BuildSettings &settings, const TypeFormat &format = TypeFormat() );
 	//! Removes an instance from Factory watch list
 	void unwatch( const std::type_index &typeIndex, void* address );
+	//! Returns the settings used when none are specified: the ones of the app vcxproj on Windows. Elsewhere the ones of the command compiling sourcePath 
+	//! in the compile_commands.json of the build directory found by ProjectConfiguration, or the default BuildSettings if there's no such database
+	static rt::BuildSettings getDefaultBuildSettings( const ci::fs::path &sourcePath = ci::fs::path() );
 
 	class CI_RT_API Type;
 	Type* getType( const std::type_index &typeIndex );
@@ -109,6 +128,17 @@ public:
 	const std::map<std::type_index,Type>&	getTypes() const { return mTypes; }
 	std::map<std::type_index,Type>&			getTypes() { return mTypes; }
 
+	//! Sets how long a type waits for its sources to stop changing before being rebuilt. Changes made during that time are merged into a single build. Defaults to 100ms
+	void setBuildDelay( const std::chrono::milliseconds &delay ) { mBuildDelay = delay; }
+	//! Returns how long a type waits for its sources to stop changing before being rebuilt
+	std::chrono::milliseconds getBuildDelay() const { return mBuildDelay; }
+	//! Sets how many types can be prebuilt over the life of the app, see TypeFormat::prebuild. The prebuilds run one at a time while no other build is in progress. Defaults to 32
+	void setMaxPrebuilds( size_t count ) { mMaxPrebuilds = count; }
+	//! Returns how many types can be prebuilt over the life of the app
+	size_t getMaxPrebuilds() const { return mMaxPrebuilds; }
+	//! Returns the number of builds avoided because the saved sources only differed by whitespace or comments
+	size_t getNumSkippedBuilds() const { return mNumSkippedBuilds; }
+
 	class CI_RT_API Type {
 	public:
 		template<typename T>
@@ -149,6 +179,10 @@ public:
 		const std::vector<Version>&	getVersions() const { return mVersions; }
 		std::vector<Version>&		getVersions() { return mVersions; }
 
+		//! Returns the compiler timings accumulated over the builds of the type, when BuildSettings::compilerProfiling is enabled
+		const rt::CompilerProfile&	getCompilerProfile() const { return mCompilerProfile; }
+		rt::CompilerProfile&		getCompilerProfile() { return mCompilerProfile; }
+
 	protected:
 
 		// prebuild detection / snifae
@@ -211,22 +245,68 @@ public:
 		std::function<void(void*)>	mPostBuild;
 
 		std::vector<Version>		mVersions;
+		rt::CompilerProfile			mCompilerProfile;
 		std::unique_ptr<std::type_index> mTypeIndex;
 	};
 
 	void loadTypeVersion( const std::type_index &typeIndex, const Type::Version &version );
 
 protected:
+	Factory();
+
+	//! Source changes of a type waiting to be built, and the build in progress for that type
+	struct BuildRequest {
+		BuildRequest() : mPending( false ), mHeaderChanged( false ), mBuildId( 0 ), mPrebuildId( 0 ) {}
+		std::vector<ci::fs::path>				mFilePaths;
+		rt::BuildSettings						mSettings;
+		bool									mPending;
+		bool									mHeaderChanged;
+		std::chrono::steady_clock::time_point	mDeadline;
+		rt::CompilerBase::BuildId				mBuildId;
+		//! Settings of the prebuild, without the steps preparing the link and the output folder
+		rt::BuildSettings						mPrebuildSettings;
+		rt::CompilerBase::BuildId				mPrebuildId;
+		//! Token stream fingerprint of each source, as of the last change that was queued
+		std::map<ci::fs::path,uint64_t>			mFingerprints;
+		//! Headers outside of the type sources included by its last build
+		std::vector<ci::fs::path>				mDependencies;
+	};
+
+	//! Header included by the types' sources, with the types to rebuild when it changes
+	struct Dependency {
+		std::set<std::type_index>	mTypes;
+		uint64_t					mFingerprint;
+	};
+
 	template<typename T>
 	void initType( const std::type_index &typeIndex, const std::string &name );
-	void watchImpl( const std::type_index &typeIndex, void* address, const std::string &name, const std::vector<ci::fs::path> &filePaths, rt::BuildSettings settings = rt::BuildSettings().vcxproj(), const TypeFormat &format = TypeFormat() );
+	void watchImpl( const std::type_index &typeIndex, void* address, const std::string &name, const std::vector<ci::fs::path> &filePaths, rt::BuildSettings settings = getDefaultBuildSettings(), const TypeFormat &format = TypeFormat() );
 	void sourceChanged( const ci::WatchEvent &event, const std::type_index &typeIndex, const std::vector<ci::fs::path> &filePaths, const rt::BuildSettings &settings );
+	void dependencyChanged( const ci::WatchEvent &event );
+	//! Queues a build of the type, started once its sources stopped changing until deadline
+	void queueBuild( const std::type_index &typeIndex, bool headerChanged, const std::chrono::steady_clock::time_point &deadline );
+	//! Replaces the headers a type depends on by the ones reported by its last build, and watches the new ones
+	void updateDependencies( const std::type_index &typeIndex, const rt::BuildOutput &output );
+	void update();
+	void startBuild( const std::type_index &typeIndex, BuildRequest* request );
+	//! Starts the prebuild of the next type waiting for one, if nothing else is being built
+	void startPrebuild();
 	void handleBuild( const rt::BuildOutput &output, const std::type_index &typeIndex, const std::string &vtableSym );
 	void swapInstancesVtables( const std::type_index &typeIndex, const std::string &vtableSym );
 	void reconstructInstances( const std::type_index &typeIndex );
 	void* allocate( size_t size, const std::type_index &typeIndex );
 
 	std::map<std::type_index,Type> mTypes;
+	std::map<std::type_index,BuildRequest> mBuildRequests;
+	std::map<ci::fs::path,Dependency> mDependencies;
+	std::chrono::milliseconds		mBuildDelay;
+	size_t							mNumSkippedBuilds;
+	//! Types waiting for their prebuild, in the order they have been watched
+	std::deque<std::type_index>		mPrebuildQueue;
+	size_t							mMaxPrebuilds;
+	size_t							mNumPrebuilds;
+	ci::signals::ScopedConnection	mUpdateConnection;
+	ci::signals::ScopedConnection	mCleanupConnection;
 };
 
 template<typename T>
@@ -254,6 +334,12 @@ void Factory::initType( const std::type_index &typeIndex, const std::string &nam
 	}
 }
 
+template<typename T>
+void Factory::watch( void* address, const std::string &name, const std::vector<ci::fs::path> &filePaths )
+{
+	watch<T>( address, name, filePaths, getDefaultBuildSettings( filePaths.empty() ? ci::fs::path() : filePaths.front() ) );
+}
+
 template<typename T>
 void Factory::watch( void* address, const std::string &name, const std::vector<ci::fs::path> &filePaths, const rt::BuildSettings &settings, const TypeFormat &format )
 {
@@ -274,7 +360,7 @@ void* Factory::allocateAndWatch( const std::string &className, const ci::fs::pat
 	sources.push_back( headerPath );
 
 	if( ! settings ) {
-		auto buildSettings = rt::BuildSettings().vcxproj();
+		auto buildSettings = getDefaultBuildSettings( sources.front() );
 		watch<Class>( ptr, className, sources, buildSettings, format );
 	}
 	else {
@@ -288,7 +374,7 @@ void* Factory::allocateAndWatch( const std::string &className, const ci::fs::pat
 {
 	void* ptr = allocate<Class>();
 	if( ! settings ) {
-		auto buildSettings = rt::BuildSettings().vcxproj();
+		auto buildSettings = getDefaultBuildSettings( ci::fs::absolute( cppPath ) );
 		watch<Class>( ptr, className, { ci::fs::absolute( cppPath ), ci::fs::absolute( headerPath ) }, buildSettings, format );
 	}
 	else {
@@ -0,0 +1,73 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace runtime {
+
+//! Incremental 64-bit FNV-1a hash, used to fingerprint sources and settings
+class Hash {
+public:
+	Hash() : mValue( 14695981039346656037ull ) {}
+
+	//! Adds size bytes at data to the hash
+	Hash& update( const void* data, size_t size );
+	//! Adds the characters of str to the hash
+	Hash& update( std::string_view str ) { return update( str.data(), str.size() ); }
+	//! Adds value to the hash
+	Hash& update( uint64_t value ) { return update( &value, sizeof( value ) ); }
+
+	//! Returns the hash of everything added so far
+	uint64_t getValue() const { return mValue; }
+	//! Returns the hash as a 16 characters hexadecimal string
+	std::string toString() const;
+
+protected:
+	uint64_t mValue;
+};
+
+inline Hash& Hash::update( const void* data, size_t size )
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>( data );
+	uint64_t value = mValue;
+	for( size_t i = 0; i < size; ++i ) {
+		value = ( value ^ bytes[i] ) * 1099511628211ull;
+	}
+	mValue = value;
+	return *this;
+}
+
+inline std::string Hash::toString() const
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string str( 16, '0' );
+	for( size_t i = 0; i < 16; ++i ) {
+		str[15 - i] = digits[( mValue >> ( i * 4 ) ) & 0xf];
+	}
+	return str;
+}
+
+} // namespace runtime
+
+namespace rt = runtime;
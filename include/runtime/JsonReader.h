@@ -0,0 +1,220 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+
+#include "runtime/Export.h"
+#include "cinder/Exception.h"
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+class CI_RT_API JsonReaderException : public ci::Exception {
+public:
+	JsonReaderException( const std::string &message ) : ci::Exception( message ) {}
+};
+
+//! Forward only reader of json over a buffer, reading the values in place without building a document. Throws a JsonReaderException on malformed or truncated input
+class JsonReader {
+public:
+	JsonReader( const ci::fs::path &path, const char* data, size_t size, size_t position = 0 )
+		: mPath( path ), mData( data ), mSize( size ), mPosition( position )
+	{}
+
+	//! Returns the next character that isn't whitespace, or 0 at the end of the input
+	char peek()
+	{
+		while( mPosition < mSize && std::isspace( static_cast<unsigned char>( mData[mPosition] ) ) ) {
+			++mPosition;
+		}
+		return mPosition < mSize ? mData[mPosition] : 0;
+	}
+	//! Skips c if it's the next character that isn't whitespace
+	bool skip( char c )
+	{
+		if( peek() == c ) {
+			++mPosition;
+			return true;
+		}
+		return false;
+	}
+	void expect( char c )
+	{
+		if( ! skip( c ) ) {
+			error( std::string( "expected '" ) + c + "'" );
+		}
+	}
+	//! Reads a string, unescaped into value unless value is null
+	void readString( std::string* value )
+	{
+		expect( '"' );
+		while( mPosition < mSize ) {
+			// copy the runs without escapes at once
+			size_t end = mPosition;
+			while( end < mSize && mData[end] != '"' && mData[end] != '\\' ) {
+				++end;
+			}
+			if( value ) {
+				value->append( mData + mPosition, end - mPosition );
+			}
+			mPosition = end;
+			if( mPosition >= mSize ) {
+				break;
+			}
+			if( mData[mPosition++] == '"' ) {
+				return;
+			}
+			readEscape( value );
+		}
+		error( "unterminated string" );
+	}
+	//! Skips a value of any type
+	void skipValue()
+	{
+		char c = peek();
+		if( c == '"' ) {
+			readString( nullptr );
+		}
+		else if( c == '[' || c == '{' ) {
+			char close = c == '[' ? ']' : '}';
+			++mPosition;
+			if( skip( close ) ) {
+				return;
+			}
+			do {
+				if( close == '}' ) {
+					readString( nullptr );
+					expect( ':' );
+				}
+				skipValue();
+			} while( skip( ',' ) );
+			expect( close );
+		}
+		else {
+			readLiteral( nullptr );
+		}
+	}
+	//! Reads a number, true, false or null, copied as written into value unless value is null
+	void readLiteral( std::string* value )
+	{
+		peek();
+		size_t begin = mPosition;
+		while( mPosition < mSize && ( std::isalnum( static_cast<unsigned char>( mData[mPosition] ) ) || mData[mPosition] == '-' || mData[mPosition] == '+' || mData[mPosition] == '.' ) ) {
+			++mPosition;
+		}
+		if( mPosition == begin ) {
+			error( "expected a value" );
+		}
+		if( value ) {
+			value->assign( mData + begin, mPosition - begin );
+		}
+	}
+
+	size_t getPosition() const { return mPosition; }
+
+	[[noreturn]] void error( const std::string &message ) const
+	{
+		throw JsonReaderException( mPath.string() + " at offset " + std::to_string( mPosition ) + ": " + message );
+	}
+
+protected:
+	void readEscape( std::string* value )
+	{
+		if( mPosition >= mSize ) {
+			error( "unterminated string" );
+		}
+		char c = mData[mPosition++];
+		char unescaped = 0;
+		switch( c ) {
+			case '"': case '\\': case '/': unescaped = c; break;
+			case 'b': unescaped = '\b'; break;
+			case 'f': unescaped = '\f'; break;
+			case 'n': unescaped = '\n'; break;
+			case 'r': unescaped = '\r'; break;
+			case 't': unescaped = '\t'; break;
+			case 'u': {
+				uint32_t codePoint = readHex4();
+				// surrogate pair
+				if( codePoint >= 0xD800 && codePoint < 0xDC00 && mPosition + 1 < mSize && mData[mPosition] == '\\' && mData[mPosition + 1] == 'u' ) {
+					mPosition += 2;
+					codePoint = 0x10000 + ( ( codePoint - 0xD800 ) << 10 ) + ( readHex4() - 0xDC00 );
+				}
+				if( value ) {
+					appendUtf8( codePoint, value );
+				}
+				return;
+			}
+			default: error( "invalid escape sequence" );
+		}
+		if( value ) {
+			value->push_back( unescaped );
+		}
+	}
+	uint32_t readHex4()
+	{
+		if( mPosition + 4 > mSize ) {
+			error( "invalid unicode escape" );
+		}
+		uint32_t codePoint = 0;
+		for( size_t i = 0; i < 4; ++i ) {
+			char c = mData[mPosition++];
+			codePoint <<= 4;
+			if( c >= '0' && c <= '9' ) codePoint |= c - '0';
+			else if( c >= 'a' && c <= 'f' ) codePoint |= c - 'a' + 10;
+			else if( c >= 'A' && c <= 'F' ) codePoint |= c - 'A' + 10;
+			else error( "invalid unicode escape" );
+		}
+		return codePoint;
+	}
+	static void appendUtf8( uint32_t codePoint, std::string* value )
+	{
+		if( codePoint < 0x80 ) {
+			value->push_back( static_cast<char>( codePoint ) );
+		}
+		else if( codePoint < 0x800 ) {
+			value->push_back( static_cast<char>( 0xC0 | ( codePoint >> 6 ) ) );
+			value->push_back( static_cast<char>( 0x80 | ( codePoint & 0x3F ) ) );
+		}
+		else if( codePoint < 0x10000 ) {
+			value->push_back( static_cast<char>( 0xE0 | ( codePoint >> 12 ) ) );
+			value->push_back( static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) ) );
+			value->push_back( static_cast<char>( 0x80 | ( codePoint & 0x3F ) ) );
+		}
+		else {
+			value->push_back( static_cast<char>( 0xF0 | ( codePoint >> 18 ) ) );
+			value->push_back( static_cast<char>( 0x80 | ( ( codePoint >> 12 ) & 0x3F ) ) );
+			value->push_back( static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3F ) ) );
+			value->push_back( static_cast<char>( 0x80 | ( codePoint & 0x3F ) ) );
+		}
+	}
+
+	const ci::fs::path	&mPath;
+	const char*			mData;
+	size_t				mSize;
+	size_t				mPosition;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -20,6 +20,8 @@
 */
 #pragma once
 
+#include <functional>
+
 #include "cinder/Filesystem.h"
 #include "cinder/Signals.h"
 
@@ -39,6 +41,8 @@ public:
 
 	//! Updates the module with a new handle
 	void updateHandle( const ci::fs::path &path = ci::fs::path() );
+	//! Updates the module with code living in memory (ex. linked by a JIT), whose symbols are resolved by symbolLookup
+	void updateHandle( const std::string &name, const std::function<void*(const std::string&)> &symbolLookup );
 	//! Changes the disk name of the current module to enable writing a new one 
 	void unlockHandle();
 	
@@ -46,10 +50,14 @@ public:
 	// Alias to Windows HINSTANCE
 	using Handle = void*;
 #else
+	// Handle returned by dlopen
+	using Handle = void*;
 #endif
 	
 	//! Returns the current Handle to the module
 	Handle getHandle() const;
+	//! Returns the lookup of the symbols of a module living in memory, null otherwise
+	const std::function<void*(const std::string&)>& getSymbolLookup() const;
 	//! Returns the current path to the module
 	ci::fs::path getPath() const;
 	//! Returns the temporary path to the module
@@ -60,6 +68,8 @@ public:
 	bool isValid() const;
 
 	void*	getSymbolAddress( const std::string &symbol ) const;
+	//! Returns the extension of the modules on this platform (".dll" or ".so")
+	static const std::string& getExtension();
 	
 	//! Returns the signal used to notify when the Module/Handle is about to be unloaded
 	ci::signals::Signal<void(const Module&)>& getCleanupSignal();
@@ -70,6 +80,7 @@ protected:
 	Handle			mHandle;
 	ci::fs::path	mPath, mTempPath;
 	std::string		mName;
+	std::function<void*(const std::string&)> mSymbolLookup;
 	
 	ci::signals::Signal<void(const Module&)> mChangedSignal;
 	ci::signals::Signal<void(const Module&)> mCleanupSignal;
@@ -23,47 +23,111 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
 #include <memory>
 #include <thread>
 #include <future>
 #include <ostream>
 #include <sstream>
-#include <queue>
 
 #include "runtime/Export.h"
+#include "runtime/RingBuffer.h"
 
 using ProcessPtr = std::unique_ptr<class Process>;
 using ProcessRef = std::shared_ptr<class Process>;
 
 class CI_RT_API Process {
 public:
+	//! Scheduling priority of a process and of the processes it starts
+	enum class Priority { Normal, BelowNormal, Idle };
+
+	class CI_RT_API Options {
+	public:
+		Options();
+		//! Specifies the directory the process is started in. Defaults to the current directory.
+		Options& path( const std::string &path );
+		//! Specifies whether StdOut is redirected. Defaults to true.
+		Options& redirectOutput( bool redirect = true );
+		//! Specifies whether StdErr is redirected. Defaults to true.
+		Options& redirectError( bool redirect = true );
+		//! Specifies whether StdIn is redirected. Defaults to true.
+		Options& redirectInput( bool redirect = true );
+		//! Keeps a copy of everything read from StdOut and StdErr for getOutputSync and getErrorSync, even what has already been consumed asynchronously. Disabled by default as this grows for the whole life of the process.
+		Options& accumulateOutput( bool accumulate = true );
+		//! Specifies the size in bytes of the StdOut and StdErr buffers (rounded up to the next power of two). When a buffer is full the process is not read anymore until it's consumed. Defaults to 64KB.
+		Options& bufferCapacity( size_t capacity );
+		//! Specifies the environment of the process as a list of NAME=VALUE strings. Defaults to the environment of the calling process.
+		Options& environment( const std::vector<std::string> &variables );
+		//! Specifies the cpu and, where supported, io priority of the process and of the processes it starts. Defaults to Normal.
+		Options& priority( Priority priority );
+		//! Restricts the process and the processes it starts to the cpus whose bit is set in mask, bit 0 being the first cpu. Defaults to 0 which allows every cpu.
+		Options& affinity( uint64_t mask );
+	protected:
+		friend class Process;
+		std::string	mPath;
+		bool		mRedirectOutput;
+		bool		mRedirectError;
+		bool		mRedirectInput;
+		bool		mAccumulateOutput;
+		size_t		mBufferCapacity;
+		std::vector<std::string> mEnvironment;
+		Priority	mPriority;
+		uint64_t	mAffinity;
+	};
+
 	//! Constructs and initialize a new process in the current directory. Will by default redirect the content of StdOut, StdErr and StdIn.
 	Process( const std::string &cmd, bool redirectOutput = true, bool redirectError = true, bool redirectInput = true );
 	//! Constructs and initialize a new process in the specified directory. Will by default redirect the content of StdOut, StdErr and StdIn.
 	Process( const std::string &cmd, const std::string &path, bool redirectOutput = true, bool redirectError = true, bool redirectInput = true );
+	//! Constructs and initialize a new process with the specified Options.
+	Process( const std::string &cmd, const Options &options );
+	//! Constructs and initialize a new process executing args[0] directly with the arguments args[1..], without going through a shell. args[0] should be a full path.
+	Process( const std::vector<std::string> &args, const Options &options = Options() );
 	
-	//! Waits for the output redirection thread to finish and returns its string 
+	//! Waits for the output stream to be closed and returns its content. Returns the whole output if accumulateOutput is enabled, otherwise what hasn't been consumed by getOutputAsync.
 	std::string	getOutputSync();
-	//! Waits for the error redirection thread to finish and returns its string
+	//! Waits for the error stream to be closed and returns its content. Returns the whole error if accumulateOutput is enabled, otherwise what hasn't been consumed by getErrorAsync.
 	std::string	getErrorSync();
-	//! Pops and returns the first output available. Returns an empty string if no output is available.
+	//! Returns all the output available. Returns an empty string if no output is available.
 	std::string	getOutputAsync();
-	//! Pops and returns the first error available. Returns an empty string if no error is available.
+	//! Returns all the error available. Returns an empty string if no error is available.
 	std::string	getErrorAsync();
-	//! Returns whether the a new output from the redirection thread is available
-	bool isOutputAvailable();
-	//! Returns whether the error from the redirection thread is available
-	bool isErrorAvailable();
+	//! Calls lineFn for each complete line of output available, without its line terminator. Lines are views of the buffer storage, only valid during the call. A trailing incomplete line is kept until completed or until the stream is closed. Returns the number of lines read.
+	size_t readOutputLines( const std::function<void(std::string_view)> &lineFn );
+	//! Calls lineFn for each complete line of error available, without its line terminator. Lines are views of the buffer storage, only valid during the call. A trailing incomplete line is kept until completed or until the stream is closed. Returns the number of lines read.
+	size_t readErrorLines( const std::function<void(std::string_view)> &lineFn );
+	//! Returns whether new output is available
+	bool isOutputAvailable() const;
+	//! Returns whether new error is available
+	bool isErrorAvailable() const;
+	//! Returns whether StdOut has been closed by the process and everything has been read
+	bool isOutputClosed() const;
+	//! Returns whether StdErr has been closed by the process and everything has been read
+	bool isErrorClosed() const;
+
+	//! Returns whether the process is still running, without blocking
+	bool isRunning();
+	//! Forcefully stops the process. terminate() still needs to be called to release its resources
+	void kill();
 
-	//! Waits for the process to terminate and returns its exit code
+	//! Waits for the process to terminate and returns its exit code. Output that doesn't fit in the buffers past this point is discarded.
 	int16_t terminate();
 	//! Closes the input pipe and read all waiting commands
 	void closeInput();
 
+	//! Returns the environment of the calling process as a list of NAME=VALUE strings
+	static std::vector<std::string> getEnvironment();
+	//! Quotes arg so that it's parsed back as is by CommandLineToArgvW, the CRT and msvc response files
+	static std::string quoteArgument( const std::string &arg );
+
 	//! Destructor (Closes the process and threads)
 	~Process();
 protected:
 	
+	//! Starts the process, either through the shell when cmd isn't empty or directly with args
+	void initialize( const std::string &cmd, const std::vector<std::string> &args, const Options &options );
 	//! Write to the input pipe
 	bool write( const std::string &cmd );
 	template <typename T> friend inline Process& operator <<(Process& process, const T &value );
@@ -71,26 +135,21 @@ protected:
 	friend inline Process& operator <<(Process& process, std::ostream&(*f)(std::ostream&) );
 	friend inline ProcessPtr& operator <<(ProcessPtr& process, std::ostream&(*f)(std::ostream&) );
 
-	bool							mProcessRunning;
-	bool							mIsOutputQueueEmpty;
-	bool							mIsErrorQueueEmpty;
-	std::mutex						mOutputQueueMutex;
-	std::mutex						mOutputQueueEmptyMutex;
-	std::mutex						mErrorQueueMutex;
-	std::mutex						mErrorQueueEmptyMutex;
-	std::queue<std::string>			mOutputQueue;
-	std::queue<std::string>			mErrorQueue;
-	std::unique_ptr<std::thread>	mOutputReadThread;
-	std::unique_ptr<std::thread>	mErrorReadThread;
-	std::future<std::string>		mOutputFuture;
-	std::future<std::string>		mErrorFuture;
+	//! StdOut or StdErr redirection. Defined in Process.cpp
+	struct Stream;
+	using StreamPtr = std::unique_ptr<Stream>;
+
+	bool		mProcessRunning;
+	int16_t		mExitCode;
+	StreamPtr	mOutput;
+	StreamPtr	mError;
 
 #if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
-	void* mOutputRead;
-	void* mErrorRead;
 	void* mInputWrite;
 	void* mProcess;
 #else
+	int mPid;
+	int mInputWrite;
 #endif
 };
 
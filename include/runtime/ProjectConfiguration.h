@@ -39,6 +39,8 @@ public:
 	std::string getPlatformToolset() const;
 	ci::fs::path getProjectPath() const;
 	ci::fs::path getProjectDir() const;
+	//! Returns the closest directory above the executable containing a compile_commands.json, usually the CMake build directory. Empty if there's none
+	ci::fs::path getBuildDir() const;
 	
 	void setConfiguration( const std::string &config );
 	void setPlatform( const std::string &platform );
@@ -46,6 +48,7 @@ public:
 	void setPlatformToolset( const std::string &toolset );
 	void setProjectPath( const ci::fs::path &path );
 	void setProjectDir( const ci::fs::path &dir );
+	void setBuildDir( const ci::fs::path &dir );
 
 	std::string printToString() const;
 
@@ -56,6 +59,7 @@ protected:
 	std::string mPlatformToolset;
 	ci::fs::path mProjectPath;
 	ci::fs::path mProjectDir;
+	ci::fs::path mBuildDir;
 };
 
 class CI_RT_API ProjectConfigurationException : public ci::Exception {
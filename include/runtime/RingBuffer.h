@@ -0,0 +1,151 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+namespace runtime {
+
+//! Fixed-capacity lock-free byte ring buffer for a single producer thread and a single consumer thread.
+//! Nothing is allocated after construction; the producer is expected to back off when write() returns less than asked.
+class RingBuffer {
+public:
+	//! Contiguous span of the ring storage. A region can wrap around the end of the storage, hence the two parts.
+	struct Region {
+		char*	mFirst;
+		size_t	mFirstSize;
+		char*	mSecond;
+		size_t	mSecondSize;
+		size_t	getSize() const { return mFirstSize + mSecondSize; }
+	};
+
+	//! Constructs a ring buffer of capacity bytes rounded up to the next power of two
+	explicit RingBuffer( size_t capacity = 65536 );
+
+	RingBuffer( const RingBuffer & ) = delete;
+	RingBuffer& operator=( const RingBuffer & ) = delete;
+
+	//! Returns the capacity of the buffer in bytes
+	size_t getCapacity() const { return mCapacity; }
+	//! Returns the number of bytes ready to be read. Exact from the consumer thread, a lower bound from the producer
+	size_t getSize() const { return mHead.load( std::memory_order_acquire ) - mTail.load( std::memory_order_acquire ); }
+	//! Returns the number of bytes that can be written. Exact from the producer thread, a lower bound from the consumer
+	size_t getFreeSpace() const { return mCapacity - getSize(); }
+	//! Returns whether there's nothing to read
+	bool isEmpty() const { return getSize() == 0; }
+	//! Returns whether there's no space left to write
+	bool isFull() const { return getFreeSpace() == 0; }
+
+	// Producer
+	//! Copies up to size bytes into the buffer and returns the number of bytes actually written
+	size_t write( const char* data, size_t size );
+	//! Returns the writable part of the storage, to be filled in place and published with commit()
+	Region getWriteRegion();
+	//! Publishes size bytes previously written in the region returned by getWriteRegion()
+	void commit( size_t size ) { mHead.store( mHead.load( std::memory_order_relaxed ) + size, std::memory_order_release ); }
+
+	// Consumer
+	//! Copies up to size bytes out of the buffer and returns the number of bytes actually read
+	size_t read( char* data, size_t size );
+	//! Appends everything available to output and returns the number of bytes read
+	size_t read( std::string* output );
+	//! Returns the readable part of the storage without consuming it
+	Region getReadRegion() const;
+	//! Releases size bytes previously obtained with getReadRegion()
+	void consume( size_t size ) { mTail.store( mTail.load( std::memory_order_relaxed ) + size, std::memory_order_release ); }
+
+protected:
+	size_t						mCapacity;
+	size_t						mMask;
+	std::unique_ptr<char[]>		mData;
+	// head and tail are ever increasing, and on separate cache lines to avoid false sharing between the two threads
+	alignas(64) std::atomic<size_t>	mHead;
+	alignas(64) std::atomic<size_t>	mTail;
+};
+
+inline RingBuffer::RingBuffer( size_t capacity )
+	: mCapacity( 1 ), mHead( 0 ), mTail( 0 )
+{
+	while( mCapacity < capacity ) {
+		mCapacity <<= 1;
+	}
+	mMask = mCapacity - 1;
+	mData.reset( new char[mCapacity] );
+}
+
+inline RingBuffer::Region RingBuffer::getWriteRegion()
+{
+	size_t head = mHead.load( std::memory_order_relaxed );
+	size_t tail = mTail.load( std::memory_order_acquire );
+	size_t available = mCapacity - ( head - tail );
+	size_t offset = head & mMask;
+	size_t first = std::min( available, mCapacity - offset );
+	return { mData.get() + offset, first, mData.get(), available - first };
+}
+
+inline RingBuffer::Region RingBuffer::getReadRegion() const
+{
+	size_t tail = mTail.load( std::memory_order_relaxed );
+	size_t head = mHead.load( std::memory_order_acquire );
+	size_t available = head - tail;
+	size_t offset = tail & mMask;
+	size_t first = std::min( available, mCapacity - offset );
+	return { mData.get() + offset, first, mData.get(), available - first };
+}
+
+inline size_t RingBuffer::write( const char* data, size_t size )
+{
+	Region region = getWriteRegion();
+	size = std::min( size, region.getSize() );
+	size_t first = std::min( size, region.mFirstSize );
+	std::memcpy( region.mFirst, data, first );
+	std::memcpy( region.mSecond, data + first, size - first );
+	commit( size );
+	return size;
+}
+
+inline size_t RingBuffer::read( char* data, size_t size )
+{
+	Region region = getReadRegion();
+	size = std::min( size, region.getSize() );
+	size_t first = std::min( size, region.mFirstSize );
+	std::memcpy( data, region.mFirst, first );
+	std::memcpy( data + first, region.mSecond, size - first );
+	consume( size );
+	return size;
+}
+
+inline size_t RingBuffer::read( std::string* output )
+{
+	Region region = getReadRegion();
+	output->append( region.mFirst, region.mFirstSize );
+	output->append( region.mSecond, region.mSecondSize );
+	consume( region.getSize() );
+	return region.getSize();
+}
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -0,0 +1,94 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "runtime/BuildCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <functional>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+BuildCache::BuildCache( const ci::fs::path &directory )
+: mDirectory( directory )
+{
+}
+
+bool BuildCache::fetch( const std::string &key, const std::vector<ci::fs::path> &paths, std::vector<ci::fs::path>* fetchedPaths ) const
+{
+	std::error_code error;
+	auto entry = mDirectory / key;
+	if( paths.empty() || ! fs::exists( entry / paths.front().filename(), error ) ) {
+		return false;
+	}
+
+	for( const auto &path : paths ) {
+		if( fs::exists( entry / path.filename(), error ) ) {
+			fs::copy_file( entry / path.filename(), path, fs::copy_options::overwrite_existing, error );
+			if( error ) {
+				return false;
+			}
+			if( fetchedPaths ) {
+				fetchedPaths->push_back( path );
+			}
+		}
+	}
+	return true;
+}
+
+void BuildCache::store( const std::string &key, const std::vector<ci::fs::path> &paths ) const
+{
+	std::error_code error;
+	auto entry = mDirectory / key;
+	if( fs::exists( entry, error ) ) {
+		return;
+	}
+
+	// fill a private folder first and rename it, so that other apps sharing the cache never see a partial entry
+	static std::atomic<uint64_t> sCounter( 0 );
+	auto unique = std::hash<std::thread::id>()( std::this_thread::get_id() ) ^ std::chrono::steady_clock::now().time_since_epoch().count();
+	auto staging = mDirectory / ( key + ".tmp" + std::to_string( unique ) + "_" + std::to_string( sCounter++ ) );
+	fs::create_directories( staging, error );
+	if( error ) {
+		return;
+	}
+	for( const auto &path : paths ) {
+		if( fs::exists( path, error ) ) {
+			fs::copy_file( path, staging / path.filename(), fs::copy_options::overwrite_existing, error );
+		}
+		// an entry missing a file would be fetched anyway and leave the previous copy of that file in place
+		if( error ) {
+			fs::remove_all( staging, error );
+			return;
+		}
+	}
+	fs::rename( staging, entry, error );
+	// another app stored the same entry in the meantime
+	if( error ) {
+		fs::remove_all( staging, error );
+	}
+}
+
+} // namespace runtime
@@ -0,0 +1,183 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "runtime/BuildLog.h"
+
+#include "cinder/app/App.h"
+#include "cinder/Log.h"
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+BuildLog& BuildLog::instance()
+{
+	static BuildLog log;
+	return log;
+}
+
+BuildLog::BuildLog()
+	: mWriting( false ), mRunning( true ), mConsoleEnabled( true ), mEnabledCategories( ~0u ), mNumListeners( 0 ), mNextListenerId( 1 ), mRateLimit( 200 ), mNumRateWindowMessages( 0 ), mNumRateWindowDropped( 0 ), mNumDroppedMessages( 0 )
+{
+	mThread = std::thread( &BuildLog::run, this );
+}
+
+BuildLog::~BuildLog()
+{
+	shutdown();
+}
+
+void BuildLog::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mRunning = false;
+	}
+	mWakeUp.notify_one();
+	if( mThread.joinable() && mThread.get_id() != std::this_thread::get_id() ) {
+		mThread.join();
+	}
+}
+
+void BuildLog::write( Category category, std::string text )
+{
+	if( ! isCategoryEnabled( category ) ) {
+		return;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( ! mRunning ) {
+			return;
+		}
+
+		// warnings and verbose output can flood the log, errors and results always get through
+		if( mRateLimit ) {
+			if( now - mRateWindowStart >= std::chrono::seconds( 1 ) ) {
+				if( mNumRateWindowDropped ) {
+					mMessages.push_back( { Category::Info, "1>  " + to_string( mNumRateWindowDropped ) + " messages dropped by the build log rate limit", std::chrono::system_clock::now() } );
+				}
+				mRateWindowStart = now;
+				mNumRateWindowMessages = 0;
+				mNumRateWindowDropped = 0;
+			}
+			if( ( category == Category::Warning || category == Category::Verbose ) && ++mNumRateWindowMessages > mRateLimit ) {
+				++mNumRateWindowDropped;
+				++mNumDroppedMessages;
+				return;
+			}
+		}
+
+		mMessages.push_back( { category, std::move( text ), std::chrono::system_clock::now() } );
+	}
+	mWakeUp.notify_one();
+}
+
+void BuildLog::flush()
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+	mDrained.wait( lock, [this]() { return ( mMessages.empty() && ! mWriting ) || ! mRunning; } );
+}
+
+void BuildLog::setCategoryEnabled( Category category, bool enabled )
+{
+	if( enabled ) {
+		mEnabledCategories |= getCategoryMask( category );
+	}
+	else {
+		mEnabledCategories &= ~getCategoryMask( category );
+	}
+}
+
+void BuildLog::setRateLimit( size_t messagesPerSecond )
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	mRateLimit = messagesPerSecond;
+}
+
+size_t BuildLog::addListener( const std::function<void(const Message&)> &listener )
+{
+	std::lock_guard<std::mutex> lock( mListenersMutex );
+	mListeners[mNextListenerId] = listener;
+	mNumListeners = mListeners.size();
+	return mNextListenerId++;
+}
+
+void BuildLog::removeListener( size_t id )
+{
+	std::lock_guard<std::mutex> lock( mListenersMutex );
+	mListeners.erase( id );
+	mNumListeners = mListeners.size();
+}
+
+void BuildLog::run()
+{
+	std::deque<Message> messages;
+	std::string text;
+	std::unique_lock<std::mutex> lock( mMutex );
+	while( true ) {
+		mWakeUp.wait( lock, [this]() { return ! mMessages.empty() || ! mRunning; } );
+		if( mMessages.empty() && ! mRunning ) {
+			break;
+		}
+
+		// take everything queued so far and write it without holding the lock
+		messages.swap( mMessages );
+		mWriting = true;
+		lock.unlock();
+
+		if( mConsoleEnabled ) {
+			text.clear();
+			for( const auto &message : messages ) {
+				text += message.mText;
+				text += '\n';
+			}
+			// CI_LOG_* writes to the same console from other threads while holding the mutex of the log manager
+			if( auto logManager = log::LogManager::instance() ) {
+				std::lock_guard<std::mutex> consoleLock( logManager->getMutex() );
+				app::console() << text << std::flush;
+			}
+			else {
+				app::console() << text << std::flush;
+			}
+		}
+		{
+			std::lock_guard<std::mutex> listenersLock( mListenersMutex );
+			for( const auto &listener : mListeners ) {
+				for( const auto &message : messages ) {
+					listener.second( message );
+				}
+			}
+		}
+		messages.clear();
+
+		lock.lock();
+		mWriting = false;
+		if( mMessages.empty() ) {
+			mDrained.notify_all();
+		}
+	}
+	mDrained.notify_all();
+}
+
+} // namespace runtime
@@ -72,6 +72,14 @@ std::vector<std::string>& BuildOutput::getWarnings()
 {
 	return mWarnings;
 }
+const std::vector<Diagnostic>& BuildOutput::getDiagnostics() const
+{
+	return mDiagnostics;
+}
+std::vector<Diagnostic>& BuildOutput::getDiagnostics()
+{
+	return mDiagnostics;
+}
 
 const BuildSettings& BuildOutput::getBuildSettings() const
 {
@@ -81,6 +89,40 @@ std::chrono::system_clock::time_point BuildOutput::getTimePoint() const
 {
 	return mTimePoint;
 }
+const std::vector<BuildOutput::JobTiming>& BuildOutput::getJobTimings() const
+{
+	return mJobTimings;
+}
+std::vector<BuildOutput::JobTiming>& BuildOutput::getJobTimings()
+{
+	return mJobTimings;
+}
+
+const std::function<void*(const std::string&)>& BuildOutput::getSymbolLookup() const
+{
+	return mSymbolLookup;
+}
+void BuildOutput::setSymbolLookup( const std::function<void*(const std::string&)> &symbolLookup )
+{
+	mSymbolLookup = symbolLookup;
+}
+
+const std::vector<ci::fs::path>& BuildOutput::getDependencies() const
+{
+	return mDependencies;
+}
+std::vector<ci::fs::path>& BuildOutput::getDependencies()
+{
+	return mDependencies;
+}
+const CompilerProfile& BuildOutput::getCompilerProfile() const
+{
+	return mCompilerProfile;
+}
+CompilerProfile& BuildOutput::getCompilerProfile()
+{
+	return mCompilerProfile;
+}
 
 void BuildOutput::setOutputPath( const ci::fs::path &path )
 {
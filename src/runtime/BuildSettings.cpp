@@ -21,16 +21,31 @@
 
 #include "runtime/BuildSettings.h"
 #include "runtime/ProjectConfiguration.h"
+#include "runtime/CompileDatabase.h"
+#include "runtime/Hash.h"
+#include "cinder/FileWatcher.h"
 #include "cinder/Log.h"
+#include "cinder/Utilities.h"
 #include "cinder/Xml.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
 using namespace std;
 using namespace ci;
 
 namespace runtime {
 
 BuildSettings::BuildSettings()
-: mVerbose( false ), mCreatePch( false ), mUsePch( false )
+: mVerbose( false ), mCompilerProfiling( false ), mCreatePch( false ), mUsePch( false ), mNumParallelJobs( 0 ), mJobPriority( Process::Priority::Normal ), mJobAffinity( 0 ),
+	mOptimization( Optimization::Default ), mIntrinsicFunctions( false ), mInlineFunctionExpansion( InlineFunctionExpansion::Default ),
+	mEnhancedInstructionSet( InstructionSet::Default ), mFloatingPointModel( FloatingPointModel::Default ), mFavorSizeOrSpeed( FavorSizeOrSpeed::Default )
 {
 }
 
@@ -54,47 +69,149 @@ namespace {
 		str.swap(wsRet); // faster than str = wsRet;
 	}
 
-	bool matchCondition( const std::string &condition, const ProjectConfiguration &config ) 
+	//! Expands the $(Name) macros of msbuild in a single pass over the input. Names are case insensitive and looked up in the 
+	//! system, project and user macros, then in the environment. Macro values are expanded as well, undefined macros expand to nothing
+	class MacroExpander {
+	public:
+		MacroExpander( const BuildSettings &settings, const ProjectConfiguration &config );
+
+		//! Sets the value of the macro $(name)
+		void set( const string &name, const string &value );
+		//! Sets the value of a user macro, name being $(Name) or any other text to be replaced as is
+		void setUserMacro( const string &name, const string &value );
+		//! Returns input with its macros expanded
+		string expand( const string &input ) const;
+		//! Returns the environment variables read by the expansions so far, with their values
+		const std::map<string, string>& getEnvironment() const { return mEnvironment; }
+
+	protected:
+		void expand( const string &input, string* output, size_t depth ) const;
+
+		std::unordered_map<string, string>	mMacros;
+		//! user macros that aren't of the $(Name) form, replaced as they are after the expansion
+		std::map<string, string>			mLiterals;
+		mutable std::map<string, string>	mEnvironment;
+	};
+
+	string toLower( string str )
 	{
-		if( condition.find( "==" ) == string::npos || condition.find( "$(Configuration)" ) == string::npos || condition.find( "$(Platform)" ) == string::npos ) {
-			return false;
+		std::transform( str.begin(), str.end(), str.begin(), []( char c ) { return static_cast<char>( std::tolower( static_cast<unsigned char>( c ) ) ); } );
+		return str;
+	}
+
+	MacroExpander::MacroExpander( const BuildSettings &settings, const ProjectConfiguration &config )
+	{
+		auto projectDir = config.getProjectDir().string() + "/";
+		set( "Configuration", config.getConfiguration() );
+		set( "Platform", config.getPlatform() );
+		set( "PlatformTarget", config.getPlatformTarget() );
+		set( "PlatformToolset", config.getPlatformToolset() );
+		set( "ProjectDir", projectDir );
+		set( "ProjectPath", config.getProjectPath().string() );
+		set( "ProjectName", config.getProjectPath().stem().string() );
+		set( "ProjectFileName", config.getProjectPath().filename().string() );
+		set( "ProjectExt", config.getProjectPath().extension().string() );
+		// the solution isn't known, msbuild uses the project directory as well when building a project alone
+		set( "SolutionDir", projectDir );
+		// msbuild defaults, replaced by the values of the project when it has them
+		set( "TargetName", "$(ProjectName)" );
+		set( "OutDir", "$(SolutionDir)$(Platform)\\$(Configuration)\\" );
+		set( "IntDir", "$(Platform)\\$(Configuration)\\" );
+
+		for( const auto &macro : settings.getUserMacros() ) {
+			setUserMacro( macro.first, macro.second );
 		}
-		// extract left and right part of the condition
-		string conditionLhs = condition.substr( 1, condition.find_last_of( "==" ) - 3 );
-		string conditionRhs = condition.substr( condition.find_last_of( "==" ) + 2 );
-		conditionRhs = conditionRhs.substr( 0, conditionRhs.length() - 1 );
-		// replace macros
-		replaceAll( conditionLhs, "$(Configuration)", config.getConfiguration() );
-		replaceAll( conditionLhs, "$(Platform)", config.getPlatform() );
-		return ( conditionLhs == conditionRhs );
-	};
+	}
 
-	string replaceVcxprojMacros( const std::string &input, BuildSettings* settings, const ProjectConfiguration &config )
+	void MacroExpander::set( const string &name, const string &value )
 	{
-		string output = input;
+		mMacros[toLower( name )] = value;
+	}
 
-		// TODO: we may want these to be added to a map of Macros, which includes both user and system (similar to Visual Studio's 'Macros' pane)
-		replaceAll( output, "$(Configuration)", config.getConfiguration() );
-		replaceAll( output, "$(Platform)", config.getPlatform() );
-		replaceAll( output, "$(PlatformTarget)", config.getPlatformTarget() );
-		replaceAll( output, "$(PlatformToolset)", config.getPlatformToolset() );
-		replaceAll( output, "$(ProjectDir)", config.getProjectDir().string() + "/" );
-		#pragma warning(suppress: 4996)
-		if( auto cinderPath = std::getenv( "CINDER_PATH" ) ) {
-			replaceAll( output, "$(CINDER_PATH)", cinderPath );
+	void MacroExpander::setUserMacro( const string &name, const string &value )
+	{
+		if( name.size() > 3 && name.compare( 0, 2, "$(" ) == 0 && name.back() == ')' ) {
+			set( name.substr( 2, name.size() - 3 ), value );
 		}
+		else {
+			mLiterals[name] = value;
+		}
+	}
 
-		// replace user macros
-		for( const auto &macro : settings->getUserMacros() ) {
-			replaceAll( output, macro.first, macro.second );
+	string MacroExpander::expand( const string &input ) const
+	{
+		if( input.find( "$(" ) == string::npos && mLiterals.empty() ) {
+			return input;
 		}
 
+		string output;
+		output.reserve( input.size() );
+		expand( input, &output, 0 );
+		for( const auto &literal : mLiterals ) {
+			replaceAll( output, literal.first, literal.second );
+		}
 		return output;
 	}
 
+	void MacroExpander::expand( const string &input, string* output, size_t depth ) const
+	{
+		// macros referencing each other stop expanding past this depth
+		static const size_t maxDepth = 16;
+
+		size_t pos = 0;
+		while( pos < input.size() ) {
+			size_t start = input.find( "$(", pos );
+			size_t end = start == string::npos ? string::npos : input.find( ')', start + 2 );
+			// property functions like $([System.IO.Path]::Combine(...)) are left as they are
+			if( end == string::npos || input[start + 2] == '[' ) {
+				size_t next = end == string::npos ? input.size() : start + 2;
+				output->append( input, pos, next - pos );
+				pos = next;
+				continue;
+			}
+
+			output->append( input, pos, start - pos );
+			pos = end + 1;
+
+			auto name = input.substr( start + 2, end - start - 2 );
+			auto macro = mMacros.find( toLower( name ) );
+			if( macro != mMacros.end() ) {
+				if( depth < maxDepth ) {
+					expand( macro->second, output, depth + 1 );
+				}
+				else {
+					output->append( macro->second );
+				}
+				continue;
+			}
+
+		#if defined( _MSC_VER )
+			#pragma warning(suppress: 4996)
+		#endif
+			auto variable = std::getenv( name.c_str() );
+			mEnvironment[name] = variable ? variable : "";
+			if( variable ) {
+				output->append( variable );
+			}
+		}
+	}
+
+	bool matchCondition( const std::string &condition, const MacroExpander &macros ) 
+	{
+		if( condition.find( "==" ) == string::npos || condition.find( "$(Configuration)" ) == string::npos || condition.find( "$(Platform)" ) == string::npos ) {
+			return false;
+		}
+		// extract left and right part of the condition
+		string conditionLhs = condition.substr( 1, condition.find_last_of( "==" ) - 3 );
+		string conditionRhs = condition.substr( condition.find_last_of( "==" ) + 2 );
+		conditionRhs = conditionRhs.substr( 0, conditionRhs.length() - 1 );
+		// replace macros
+		return ( macros.expand( conditionLhs ) == conditionRhs );
+	};
+
 	// Note: currently only supporting parsing UserMacros for property sheets, and each property sheet parsed overrides the previous one.
 	// TODO: look into supporting the rest of prop sheet features
-	void parsePropertySheet( BuildSettings* settings, const fs::path &fullPath )
+	void parsePropertySheet( BuildSettings* settings, MacroExpander* macros, const fs::path &fullPath )
 	{
 		if( ! fs::exists( fullPath ) ) {
 			CI_LOG_E( "expected property sheet doesn't exist at: " << fullPath << ", skipping." );
@@ -115,16 +232,29 @@ namespace {
 						auto name = "$(" + macroNode->getTag() + ")";
 						auto value = macroNode->getValue<string>();
 						settings->userMacro( name, value );
+						macros->setUserMacro( name, value );
 					}
 				}
 			}
 		}
 	}
 
-	void parseVcxproj( BuildSettings* settings, const XmlTree &node, const ProjectConfiguration &config, bool matched = false )
+	//! Returns the enumerator whose msbuild name is value, or fallback if there's none
+	template<typename T>
+	T parseEnumerator( const string &value, std::initializer_list<std::pair<const char*, T>> enumerators, T fallback )
+	{
+		for( const auto &enumerator : enumerators ) {
+			if( value == enumerator.first ) {
+				return enumerator.second;
+			}
+		}
+		return fallback;
+	}
+
+	void parseVcxproj( BuildSettings* settings, MacroExpander* macros, const XmlTree &node, const ProjectConfiguration &config, vector<fs::path>* propertySheets = nullptr, bool matched = false )
 	{
 		if( ! matched && node.hasAttribute( "Condition" ) ) {
-			matched = matchCondition( node.getAttributeValue<string>( "Condition" ), config );
+			matched = matchCondition( node.getAttributeValue<string>( "Condition" ), *macros );
 
 			if( ! matched ) {
 				return;
@@ -132,18 +262,23 @@ namespace {
 		}
 
 		if( node.getTag() == "OutDir" ) {
-			auto outDir = fs::path( replaceVcxprojMacros( node.getValue<string>(), settings, config ) );
+			auto outDir = fs::path( macros->expand( node.getValue<string>() ) );
+			macros->set( "OutDir", outDir.string() );
 //			settings->outputPath( outDir.parent_path() );
 		}
 		else if( node.getTag() == "IntDir" ) {
-			auto intDir = fs::path( replaceVcxprojMacros( node.getValue<string>(), settings, config ) );
+			auto intDir = fs::path( macros->expand( node.getValue<string>() ) );
+			macros->set( "IntDir", intDir.string() );
 			settings->intermediatePath( intDir.parent_path() );
 		}
+		else if( node.getTag() == "TargetName" ) {
+			macros->set( "TargetName", macros->expand( node.getValue<string>() ) );
+		}
 		else if( node.getTag() == "LinkIncremental" ) {
 			//console() << "LinkIncremental = " << node.getValue<string>() << endl;
 		}
 		else if( node.getTag() == "AdditionalIncludeDirectories" ) {
-			vector<string> includes = ci::split( replaceVcxprojMacros( node.getValue<string>(), settings, config ), ";" );
+			vector<string> includes = ci::split( macros->expand( node.getValue<string>() ), ";" );
 			for( const auto &inc : includes ) {
 				if( ! inc.empty() ) {
 					settings->include( fs::path( inc ) );
@@ -164,7 +299,7 @@ namespace {
 		else if( node.getTag() == "AdditionalDependencies" ) {
 			string librariesString = node.getValue<string>();
 			replaceAll( librariesString, "%(AdditionalDependencies)", "" );
-			vector<string> libraries = ci::split( replaceVcxprojMacros( librariesString, settings, config ), ";" );
+			vector<string> libraries = ci::split( macros->expand( librariesString ), ";" );
 			for( const auto &lib : libraries ) {
 				if( ! lib.empty() ) {
 					settings->library( lib );
@@ -172,13 +307,43 @@ namespace {
 			}
 		}
 		else if( node.getTag() == "AdditionalLibraryDirectories" ) {
-			vector<string> libraryDirectories = ci::split( replaceVcxprojMacros( node.getValue<string>(), settings, config ), ";" );
+			vector<string> libraryDirectories = ci::split( macros->expand( node.getValue<string>() ), ";" );
 			for( auto dir : libraryDirectories ) {
 				if( ! dir.empty() ) {
 					settings->libraryPath( fs::path( dir ) );
 				}
 			}
 		}
+		// code generation
+		else if( node.getTag() == "Optimization" ) {
+			using Optimization = BuildSettings::Optimization;
+			settings->optimization( parseEnumerator( node.getValue<string>(), { { "Disabled", Optimization::Disabled }, { "MinSpace", Optimization::MinSpace }, 
+				{ "MaxSpeed", Optimization::MaxSpeed }, { "Full", Optimization::Full } }, Optimization::Default ) );
+		}
+		else if( node.getTag() == "IntrinsicFunctions" ) {
+			settings->intrinsicFunctions( node.getValue<string>() == "true" );
+		}
+		else if( node.getTag() == "InlineFunctionExpansion" ) {
+			using InlineFunctionExpansion = BuildSettings::InlineFunctionExpansion;
+			settings->inlineFunctionExpansion( parseEnumerator( node.getValue<string>(), { { "Disabled", InlineFunctionExpansion::Disabled }, 
+				{ "OnlyExplicitInline", InlineFunctionExpansion::OnlyExplicitInline }, { "AnySuitable", InlineFunctionExpansion::AnySuitable } }, InlineFunctionExpansion::Default ) );
+		}
+		else if( node.getTag() == "EnableEnhancedInstructionSet" ) {
+			using InstructionSet = BuildSettings::InstructionSet;
+			settings->enhancedInstructionSet( parseEnumerator( node.getValue<string>(), { { "NoExtensions", InstructionSet::NoExtensions }, 
+				{ "StreamingSIMDExtensions", InstructionSet::SSE }, { "StreamingSIMDExtensions2", InstructionSet::SSE2 }, { "AdvancedVectorExtensions", InstructionSet::AVX }, 
+				{ "AdvancedVectorExtensions2", InstructionSet::AVX2 }, { "AdvancedVectorExtensions512", InstructionSet::AVX512 } }, InstructionSet::Default ) );
+		}
+		else if( node.getTag() == "FloatingPointModel" ) {
+			using FloatingPointModel = BuildSettings::FloatingPointModel;
+			settings->floatingPointModel( parseEnumerator( node.getValue<string>(), { { "Precise", FloatingPointModel::Precise }, { "Strict", FloatingPointModel::Strict }, 
+				{ "Fast", FloatingPointModel::Fast } }, FloatingPointModel::Default ) );
+		}
+		else if( node.getTag() == "FavorSizeOrSpeed" ) {
+			using FavorSizeOrSpeed = BuildSettings::FavorSizeOrSpeed;
+			settings->favorSizeOrSpeed( parseEnumerator( node.getValue<string>(), { { "Neither", FavorSizeOrSpeed::Neither }, { "Size", FavorSizeOrSpeed::Size }, 
+				{ "Speed", FavorSizeOrSpeed::Speed } }, FavorSizeOrSpeed::Default ) );
+		}
 		else if( node.getTag() == "ImportGroup" ) {
 			// parse user property sheets
 			if( node.getAttributeValue<string>( "Label" ) == "PropertySheets" ) {
@@ -193,7 +358,10 @@ namespace {
 					fs::path propSheetFullPath = config.getProjectDir() / fileName;
 
 					CI_LOG_I( "Parsing property sheet at: " << propSheetFullPath );
-					parsePropertySheet( settings, propSheetFullPath );
+					parsePropertySheet( settings, macros, propSheetFullPath );
+					if( propertySheets ) {
+						propertySheets->push_back( propSheetFullPath );
+					}
 				}
 			}
 		}
@@ -203,24 +371,493 @@ namespace {
 		}
 			
 		for( const auto &child : node.getChildren() ) {
-			parseVcxproj( settings, *child, config, matched );
+			parseVcxproj( settings, macros, *child, config, propertySheets, matched );
+		}
+	}
+
+	//! Appends the values of other to value, sharing the storage of other when value is empty
+	template<typename T>
+	void append( CopyOnWrite<T>* value, const CopyOnWrite<T> &other )
+	{
+		if( value->empty() ) {
+			value->share( other.getShared() );
+		}
+		else if( ! other.empty() ) {
+			auto &values = value->modify();
+			values.insert( values.end(), other.begin(), other.end() );
 		}
 	}
+
+	uint64_t hashValue( const vector<string> &values )
+	{
+		Hash hash;
+		for( const auto &value : values ) {
+			hash.update( value ).update( "\0", 1 );
+		}
+		return hash.getValue();
+	}
+	uint64_t hashValue( const vector<fs::path> &values )
+	{
+		Hash hash;
+		for( const auto &value : values ) {
+			hash.update( value.native().data(), value.native().size() * sizeof( fs::path::value_type ) ).update( "\0", 1 );
+		}
+		return hash.getValue();
+	}
+	uint64_t hashValue( const map<string, string> &values )
+	{
+		Hash hash;
+		for( const auto &value : values ) {
+			hash.update( value.first ).update( "\0", 1 ).update( value.second ).update( "\0", 1 );
+		}
+		return hash.getValue();
+	}
+
+	//! Replaces the storage of value by the storage of an equal value interned before, or interns it
+	template<typename T>
+	void intern( CopyOnWrite<T>* value )
+	{
+		if( value->empty() ) {
+			return;
+		}
+
+		// the pool doesn't keep the values alive, expired entries are removed when the pool doubled since the last sweep
+		static std::mutex mutex;
+		static std::unordered_multimap<uint64_t, std::weak_ptr<const T>> pool;
+		static size_t sweepSize = 64;
+
+		auto hash = hashValue( value->get() );
+		std::lock_guard<std::mutex> lock( mutex );
+		auto range = pool.equal_range( hash );
+		for( auto it = range.first; it != range.second; ++it ) {
+			auto interned = it->second.lock();
+			if( interned && *interned == value->get() ) {
+				value->share( interned );
+				return;
+			}
+		}
+
+		pool.emplace( hash, value->getShared() );
+		if( pool.size() > sweepSize ) {
+			for( auto it = pool.begin(); it != pool.end(); ) {
+				it = it->second.expired() ? pool.erase( it ) : std::next( it );
+			}
+			sweepSize = std::max<size_t>( 64, pool.size() * 2 );
+		}
+	}
+
+	//! Settings resolved from a project and its property sheets, along with the state of the files they were read from
+	struct ParsedProject {
+		struct File {
+			fs::path	mPath;
+			int64_t		mWriteTime;
+			uint64_t	mHash;
+		};
+
+		uint64_t			mKey;
+		vector<File>		mFiles;
+		//! environment variables read by the macros, with their values
+		map<string, string>	mEnvironment;
+		BuildSettings		mSettings;
+	};
+
+	//! Parsed projects indexed by key. Entries are trusted as long as they are watched and removed when one of their files changes
+	struct ProjectCache {
+		std::mutex							mMutex;
+		std::map<uint64_t, ParsedProject>	mProjects;
+		std::set<fs::path>					mWatchedFiles;
+	};
+
+	ProjectCache& getProjectCache()
+	{
+		static ProjectCache cache;
+		return cache;
+	}
+
+	int64_t getWriteTime( const fs::path &path )
+	{
+		std::error_code error;
+		auto time = fs::last_write_time( path, error );
+		return error ? 0 : static_cast<int64_t>( time.time_since_epoch().count() );
+	}
+
+	uint64_t getFileHash( const fs::path &path )
+	{
+		ifstream file( path, ios::binary );
+		if( ! file ) {
+			return 0;
+		}
+		Hash hash;
+		char buffer[16384];
+		while( file.read( buffer, sizeof( buffer ) ) || file.gcount() ) {
+			hash.update( buffer, static_cast<size_t>( file.gcount() ) );
+		}
+		return hash.getValue();
+	}
+
+	//! Returns whether none of the files and environment variables of project changed since it was parsed. Files touched without being modified get their new write time
+	bool isUpToDate( ParsedProject* project )
+	{
+		for( const auto &variable : project->mEnvironment ) {
+		#if defined( _MSC_VER )
+			#pragma warning(suppress: 4996)
+		#endif
+			auto value = std::getenv( variable.first.c_str() );
+			if( variable.second != ( value ? value : "" ) ) {
+				return false;
+			}
+		}
+		for( auto &file : project->mFiles ) {
+			auto writeTime = getWriteTime( file.mPath );
+			if( writeTime == file.mWriteTime ) {
+				continue;
+			}
+			if( getFileHash( file.mPath ) != file.mHash ) {
+				return false;
+			}
+			file.mWriteTime = writeTime;
+		}
+		return true;
+	}
+
+	//! Returns the key identifying everything but the files that the parsing of a project depends on
+	uint64_t getProjectKey( const ProjectConfiguration &config, const BuildSettings &settings )
+	{
+		Hash hash;
+		hash.update( config.getProjectPath().string() ).update( config.getProjectDir().string() );
+		hash.update( config.getConfiguration() ).update( config.getPlatform() ).update( config.getPlatformTarget() ).update( config.getPlatformToolset() );
+		for( const auto &macro : settings.getUserMacros() ) {
+			hash.update( macro.first ).update( macro.second );
+		}
+		return hash.getValue();
+	}
+
+	fs::path getSidecarPath( const ProjectConfiguration &config )
+	{
+		return config.getProjectPath().string() + ".rtcache";
+	}
+
+	//! Reads the project persisted by a previous run, returns false if there's none or if it doesn't match key
+	bool readSidecar( const fs::path &path, uint64_t key, ParsedProject* project )
+	{
+		ifstream file( path );
+		string line;
+		if( ! getline( file, line ) || line != "vcxproj-cache 3 " + std::to_string( key ) ) {
+			return false;
+		}
+
+		project->mKey = key;
+		// a corrupt or hand edited file only means parsing the project again
+		try {
+			while( getline( file, line ) ) {
+				auto fields = ci::split( line, '\t', false );
+				const auto &tag = fields.front();
+				if( tag == "file" && fields.size() == 4 ) {
+					project->mFiles.push_back( { fs::path( fields[3] ), std::stoll( fields[1] ), std::stoull( fields[2] ) } );
+				}
+				else if( tag == "env" && fields.size() == 3 ) {
+					project->mEnvironment[fields[1]] = fields[2];
+				}
+				else if( tag == "codegen" && fields.size() == 7 ) {
+					auto &settings = project->mSettings;
+					settings.optimization( static_cast<BuildSettings::Optimization>( std::stoi( fields[1] ) ) ).intrinsicFunctions( fields[2] == "1" );
+					settings.inlineFunctionExpansion( static_cast<BuildSettings::InlineFunctionExpansion>( std::stoi( fields[3] ) ) );
+					settings.enhancedInstructionSet( static_cast<BuildSettings::InstructionSet>( std::stoi( fields[4] ) ) );
+					settings.floatingPointModel( static_cast<BuildSettings::FloatingPointModel>( std::stoi( fields[5] ) ) );
+					settings.favorSizeOrSpeed( static_cast<BuildSettings::FavorSizeOrSpeed>( std::stoi( fields[6] ) ) );
+				}
+				else if( tag == "intdir" && fields.size() == 2 ) {
+					project->mSettings.intermediatePath( fields[1] );
+				}
+				else if( tag == "include" && fields.size() == 2 ) {
+					project->mSettings.include( fields[1] );
+				}
+				else if( tag == "libpath" && fields.size() == 2 ) {
+					project->mSettings.libraryPath( fields[1] );
+				}
+				else if( tag == "lib" && fields.size() == 2 ) {
+					project->mSettings.library( fields[1] );
+				}
+				else if( tag == "define" && fields.size() == 2 ) {
+					project->mSettings.define( fields[1] );
+				}
+				else if( tag == "macro" && fields.size() == 3 ) {
+					project->mSettings.userMacro( fields[1], fields[2] );
+				}
+				else {
+					return false;
+				}
+			}
+		}
+		catch( const std::logic_error & ) {
+			return false;
+		}
+		return ! project->mFiles.empty();
+	}
+
+	//! Persists project next to the project file. Skipped if a value contains a separator and can't be stored as is
+	void writeSidecar( const fs::path &path, const ParsedProject &project )
+	{
+		bool storable = true;
+		auto field = [&storable]( const string &value ) -> const string& {
+			storable = storable && value.find_first_of( "\t\n" ) == string::npos;
+			return value;
+		};
+
+		const auto &settings = project.mSettings;
+		ostringstream stream;
+		stream << "vcxproj-cache 3 " << project.mKey << "\n";
+		for( const auto &file : project.mFiles ) {
+			stream << "file\t" << file.mWriteTime << "\t" << file.mHash << "\t" << field( file.mPath.string() ) << "\n";
+		}
+		for( const auto &variable : project.mEnvironment ) {
+			stream << "env\t" << field( variable.first ) << "\t" << field( variable.second ) << "\n";
+		}
+		stream << "codegen\t" << static_cast<int>( settings.getOptimization() ) << "\t" << settings.isIntrinsicFunctionsEnabled() << "\t" 
+			<< static_cast<int>( settings.getInlineFunctionExpansion() ) << "\t" << static_cast<int>( settings.getEnhancedInstructionSet() ) << "\t" 
+			<< static_cast<int>( settings.getFloatingPointModel() ) << "\t" << static_cast<int>( settings.getFavorSizeOrSpeed() ) << "\n";
+		if( ! settings.getIntermediatePath().empty() ) {
+			stream << "intdir\t" << field( settings.getIntermediatePath().string() ) << "\n";
+		}
+		for( const auto &include : settings.getIncludes() ) {
+			stream << "include\t" << field( include.string() ) << "\n";
+		}
+		for( const auto &libraryPath : settings.getLibraryPaths() ) {
+			stream << "libpath\t" << field( libraryPath.string() ) << "\n";
+		}
+		for( const auto &library : settings.getLibraries() ) {
+			stream << "lib\t" << field( library ) << "\n";
+		}
+		for( const auto &definition : settings.getPpDefinitions() ) {
+			stream << "define\t" << field( definition ) << "\n";
+		}
+		for( const auto &macro : settings.getUserMacros() ) {
+			stream << "macro\t" << field( macro.first ) << "\t" << field( macro.second ) << "\n";
+		}
+		if( ! storable ) {
+			return;
+		}
+
+		// write a temporary file and rename it so that a reader never sees a partial file
+		auto tempPath = fs::path( path.string() + ".tmp" );
+		{
+			ofstream file( tempPath, ios::binary | ios::trunc );
+			if( ! file || ! ( file << stream.str() ) ) {
+				return;
+			}
+		}
+		std::error_code error;
+		fs::rename( tempPath, path, error );
+		if( error ) {
+			fs::remove( tempPath, error );
+		}
+	}
+
+	//! Removes the parsed projects that depend on a file that changed. The sidecar is left as it is, its files are checked when it's read
+	void projectFileChanged( const WatchEvent &event )
+	{
+		auto &cache = getProjectCache();
+		std::lock_guard<std::mutex> lock( cache.mMutex );
+		for( auto it = cache.mProjects.begin(); it != cache.mProjects.end(); ) {
+			const auto &files = it->second.mFiles;
+			if( std::any_of( files.begin(), files.end(), [&event]( const ParsedProject::File &file ) { return file.mPath == event.getFile(); } ) ) {
+				it = cache.mProjects.erase( it );
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	//! Returns the settings resolved from the project of config, from memory, from the sidecar file if its files didn't change, or by parsing the project
+	const BuildSettings& getParsedProject( const ProjectConfiguration &config, const BuildSettings &settings )
+	{
+		auto &cache = getProjectCache();
+		auto key = getProjectKey( config, settings );
+
+		std::lock_guard<std::mutex> lock( cache.mMutex );
+		auto cached = cache.mProjects.find( key );
+		if( cached != cache.mProjects.end() ) {
+			return cached->second.mSettings;
+		}
+
+		ParsedProject project;
+		auto sidecarPath = getSidecarPath( config );
+		if( ! readSidecar( sidecarPath, key, &project ) || ! isUpToDate( &project ) ) {
+			project = ParsedProject();
+			project.mKey = key;
+			// the macros already specified are used by the parsing, they are part of the key
+			for( const auto &macro : settings.getUserMacros() ) {
+				project.mSettings.userMacro( macro.first, macro.second );
+			}
+			MacroExpander macros( settings, config );
+			vector<fs::path> propertySheets;
+			parseVcxproj( &project.mSettings, &macros, XmlTree( loadFile( config.getProjectPath() ) ), config, &propertySheets );
+			project.mEnvironment = macros.getEnvironment();
+
+			project.mFiles.push_back( { config.getProjectPath(), getWriteTime( config.getProjectPath() ), getFileHash( config.getProjectPath() ) } );
+			for( const auto &sheet : propertySheets ) {
+				project.mFiles.push_back( { sheet, getWriteTime( sheet ), getFileHash( sheet ) } );
+			}
+			writeSidecar( sidecarPath, project );
+		}
+		
+		for( const auto &file : project.mFiles ) {
+			if( cache.mWatchedFiles.insert( file.mPath ).second ) {
+				FileWatcher::instance().watch( file.mPath, FileWatcher::Options().callOnWatch( false ), &projectFileChanged );
+			}
+		}
+		return cache.mProjects.emplace( key, std::move( project ) ).first->second.mSettings;
+	}
+}
+
+namespace {
+	//! Reads the value of the option at args[*index] if it's flag, either attached to it or as the next argument
+	bool readOption( const vector<string> &args, size_t* index, const char* flag, string* value )
+	{
+		const auto &arg = args[*index];
+		size_t length = std::strlen( flag );
+		if( arg.compare( 0, length, flag ) != 0 ) {
+			return false;
+		}
+		if( arg.size() > length ) {
+			*value = arg.substr( length );
+		}
+		else if( *index + 1 < args.size() ) {
+			*value = args[++*index];
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+
+	//! Returns whether arg changes the code generated, and should be the same in the app and the runtime modules
+	bool isCodeGenerationOption( const string &arg, bool msvc )
+	{
+		static const vector<string> gccPrefixes = { "-O", "-m", "-ffast-math", "-fno-fast-math", "-ffp-", "-fmath-errno", "-fno-math-errno", "-funsafe-math-optimizations", 
+			"-fno-unsafe-math-optimizations", "-ffinite-math-only", "-fno-finite-math-only", "-frounding-math", "-fno-rounding-math", "-ftrapping-math", "-fno-trapping-math", "-fexcess-precision" };
+		static const vector<string> msvcPrefixes = { "/O", "-O", "/arch:", "-arch:", "/fp:", "-fp:" };
+		for( const auto &prefix : msvc ? msvcPrefixes : gccPrefixes ) {
+			if( arg.compare( 0, prefix.size(), prefix ) == 0 ) {
+				return true;
+			}
+		}
+		return false;
+	}
+} // anonymous namespace
+
+BuildSettings& BuildSettings::compileCommands( const ci::fs::path &sourcePath, const ci::fs::path &databasePath )
+{
+	auto path = databasePath.empty() ? ProjectConfiguration::instance().getBuildDir() / "compile_commands.json" : databasePath;
+	if( ! fs::exists( path ) ) {
+		CI_LOG_E( "expected compilation database doesn't exist at: " << path << ", skipping." );
+		return *this;
+	}
+
+	CompileDatabase::Command command;
+	try {
+		if( ! CompileDatabase::load( path )->findCommand( sourcePath, &command ) || command.mArguments.empty() ) {
+			CI_LOG_E( "no command compiling " << sourcePath << " or its directory in " << path << ", skipping." );
+			return *this;
+		}
+	}
+	catch( const CompileDatabaseException &exc ) {
+		// ex. the build system is still writing the file
+		CI_LOG_E( exc.what() << ", skipping." );
+		return *this;
+	}
+
+	// cl and clang-cl take msvc options, with either / or -
+	auto compiler = toLower( fs::path( command.mArguments.front() ).stem().string() );
+	bool msvc = compiler == "cl" || compiler == "clang-cl";
+	auto resolve = [&command]( const string &path ) {
+		return fs::path( path ).is_absolute() ? fs::path( path ) : ( command.mDirectory / path ).lexically_normal();
+	};
+
+	const auto &args = command.mArguments;
+	string value;
+	for( size_t i = 1; i < args.size(); ++i ) {
+		const auto &arg = args[i];
+		if( msvc ) {
+			if( readOption( args, &i, "/I", &value ) || readOption( args, &i, "-I", &value ) ) {
+				include( resolve( value ) );
+			}
+			else if( readOption( args, &i, "/D", &value ) || readOption( args, &i, "-D", &value ) ) {
+				define( value );
+			}
+			else if( arg.compare( 0, 5, "/std:" ) == 0 || arg.compare( 0, 5, "-std:" ) == 0 || isCodeGenerationOption( arg, true ) ) {
+				compilerOption( arg );
+			}
+		}
+		else {
+			if( readOption( args, &i, "-I", &value ) || readOption( args, &i, "-isystem", &value ) || readOption( args, &i, "-iquote", &value ) || readOption( args, &i, "-idirafter", &value ) ) {
+				include( resolve( value ) );
+			}
+			else if( readOption( args, &i, "-D", &value ) ) {
+				define( value );
+			}
+			else if( arg.compare( 0, 5, "-std=" ) == 0 || arg.compare( 0, 8, "-stdlib=" ) == 0 || isCodeGenerationOption( arg, false ) ) {
+				compilerOption( arg );
+			}
+		}
+	}
+
+	return *this;
 }
 
 #if defined( CINDER_MSW )
 BuildSettings& BuildSettings::vcxproj( const ci::fs::path &path )
 {
 	const auto &projConfig = ProjectConfiguration::instance();
-	parseVcxproj( this, XmlTree( loadFile( projConfig.getProjectPath() ) ), projConfig );
+	
+	// apps watching many types would otherwise parse the same project for each of them
+	const auto &parsed = getParsedProject( projConfig, *this );
+	if( ! parsed.getIntermediatePath().empty() ) {
+		intermediatePath( parsed.getIntermediatePath() );
+	}
+	append( &mIncludes, parsed.mIncludes );
+	append( &mLibraryPaths, parsed.mLibraryPaths );
+	append( &mLibraries, parsed.mLibraries );
+	append( &mPpDefinitions, parsed.mPpDefinitions );
+	for( const auto &macro : parsed.getUserMacros() ) {
+		userMacro( macro.first, macro.second );
+	}
+
+	// the code generation follows the project so that the runtime modules run as fast as the rest of the app
+	if( parsed.mOptimization != Optimization::Default ) {
+		optimization( parsed.mOptimization );
+	}
+	if( parsed.mIntrinsicFunctions ) {
+		intrinsicFunctions();
+	}
+	if( parsed.mInlineFunctionExpansion != InlineFunctionExpansion::Default ) {
+		inlineFunctionExpansion( parsed.mInlineFunctionExpansion );
+	}
+	if( parsed.mEnhancedInstructionSet != InstructionSet::Default ) {
+		enhancedInstructionSet( parsed.mEnhancedInstructionSet );
+	}
+	if( parsed.mFloatingPointModel != FloatingPointModel::Default ) {
+		floatingPointModel( parsed.mFloatingPointModel );
+	}
+	if( parsed.mFavorSizeOrSpeed != FavorSizeOrSpeed::Default ) {
+		favorSizeOrSpeed( parsed.mFavorSizeOrSpeed );
+	}
+#if defined( _DEBUG )
+	if( mOptimization == Optimization::Default ) {
+		optimization( Optimization::Disabled );
+	}
+#endif
+	if( mFloatingPointModel == FloatingPointModel::Default ) {
+		floatingPointModel( FloatingPointModel::Precise );
+	}
 
 	return configuration( projConfig.getConfiguration() ).platform( projConfig.getPlatform() ).platformToolset( projConfig.getPlatformToolset() )
-	.compilerOption( "/nologo" ).compilerOption( "/W3" ).compilerOption( "/WX-" ).compilerOption( "/EHsc" ).compilerOption( "/RTC1" ).compilerOption( "/GS" )
-	.compilerOption( "/fp:precise" ).compilerOption( "/Zc:wchar_t" ).compilerOption( "/Zc:forScope" ).compilerOption( "/Zc:inline" ).compilerOption( "/Gd" ).compilerOption( "/TP" )
+	.compilerOption( "/nologo" ).compilerOption( "/W3" ).compilerOption( "/WX-" ).compilerOption( "/EHsc" ).compilerOption( "/GS" )
+	.compilerOption( "/Zc:wchar_t" ).compilerOption( "/Zc:forScope" ).compilerOption( "/Zc:inline" ).compilerOption( "/Gd" ).compilerOption( "/TP" )
 	//.compilerOption( "/Gm" )
 		
 #if defined( _DEBUG )
-	.compilerOption( "/Od" )
 	.compilerOption( "/Zi" )
 	.define( "_DEBUG" )
 	.compilerOption( "/MDd" )
@@ -255,8 +892,14 @@ std::string BuildSettings::printToString() const
 	str << "precompiled header: " << mPrecompiledHeader << "\n";
 	str << "output path: " << mOutputPath << "\n";
 	str << "intermediate path: " << mIntermediatePath << "\n";
+	str << "cache directory: " << mCacheDirectory << "\n";
 	str << "pdb path: " << mPdbPath << "\n";
 	str << "module name: " << mModuleName << "\n";
+	str << "parallel jobs: " << mNumParallelJobs << "\n";
+	str << "compiler profiling: " << mCompilerProfiling << "\n";
+	str << "optimization: " << static_cast<int>( mOptimization ) << ", intrinsic functions: " << mIntrinsicFunctions << ", inline function expansion: " << static_cast<int>( mInlineFunctionExpansion ) << "\n";
+	str << "enhanced instruction set: " << static_cast<int>( mEnhancedInstructionSet ) << ", floating point model: " << static_cast<int>( mFloatingPointModel ) << ", favor size or speed: " << static_cast<int>( mFavorSizeOrSpeed ) << "\n";
+	str << "job priority: " << static_cast<int>( mJobPriority ) << ", job affinity: 0x" << std::hex << mJobAffinity << std::dec << "\n";
 	str << "includes:\n";
 	for( const auto &include : mIncludes ) {
 		str << "\t- " << include << "\n";
@@ -273,6 +916,7 @@ std::string BuildSettings::printToString() const
 	for( const auto &src : mAdditionalSources ) {
 		str << "\t- " << src << "\n";
 	}
+	str << "unity source: " << mUnitySource << "\n";
 	str << "forced includes:\n";
 	for( const auto &include : mForcedIncludes ) {
 		str << "\t- " << include << "\n";
@@ -303,22 +947,22 @@ std::string BuildSettings::printToString() const
 
 BuildSettings& BuildSettings::include( const ci::fs::path &path )
 {
-	mIncludes.push_back( path );
+	mIncludes.modify().push_back( path );
 	return *this;
 }
 BuildSettings& BuildSettings::libraryPath( const ci::fs::path &path )
 {
-	mLibraryPaths.push_back( path );
+	mLibraryPaths.modify().push_back( path );
 	return *this;
 }
 BuildSettings& BuildSettings::library( const std::string &library )
 {
-	mLibraries.push_back( library );
+	mLibraries.modify().push_back( library );
 	return *this;
 }
 BuildSettings& BuildSettings::define( const std::string &definition )
 {
-	mPpDefinitions.push_back( definition );
+	mPpDefinitions.modify().push_back( definition );
 	return *this;
 }
 
@@ -354,17 +998,20 @@ BuildSettings& BuildSettings::programDatabaseAltPath( const ci::fs::path &path )
 
 BuildSettings& BuildSettings::compilerOption( const std::string &option )
 {
-	mCompilerOptions.push_back( option );
+	mCompilerOptions.modify().push_back( option );
 	return *this;
 }
 BuildSettings& BuildSettings::linkerOption( const std::string &option )
 {
-	mLinkerOptions.push_back( option );
+	mLinkerOptions.modify().push_back( option );
 	return *this;
 }
 BuildSettings& BuildSettings::userMacro( const std::string &name, const std::string &value )
 {
-	mUserMacros[name] = value;
+	auto macro = mUserMacros.get().find( name );
+	if( macro == mUserMacros.end() || macro->second != value ) {
+		mUserMacros.modify()[name] = value;
+	}
 	return *this;
 }
 
@@ -373,6 +1020,70 @@ BuildSettings& BuildSettings::verbose( bool enabled )
 	mVerbose = enabled;
 	return *this;
 }
+BuildSettings& BuildSettings::parallelJobs( size_t count )
+{
+	mNumParallelJobs = count;
+	return *this;
+}
+BuildSettings& BuildSettings::compilerProfiling( bool enabled )
+{
+	mCompilerProfiling = enabled;
+	return *this;
+}
+BuildSettings& BuildSettings::jobPriority( Process::Priority priority )
+{
+	mJobPriority = priority;
+	return *this;
+}
+BuildSettings& BuildSettings::jobAffinity( uint64_t mask )
+{
+	mJobAffinity = mask;
+	return *this;
+}
+BuildSettings& BuildSettings::optimization( Optimization level )
+{
+	mOptimization = level;
+	return *this;
+}
+BuildSettings& BuildSettings::intrinsicFunctions( bool enabled )
+{
+	mIntrinsicFunctions = enabled;
+	return *this;
+}
+BuildSettings& BuildSettings::inlineFunctionExpansion( InlineFunctionExpansion expansion )
+{
+	mInlineFunctionExpansion = expansion;
+	return *this;
+}
+BuildSettings& BuildSettings::enhancedInstructionSet( InstructionSet instructionSet )
+{
+	mEnhancedInstructionSet = instructionSet;
+	return *this;
+}
+BuildSettings& BuildSettings::floatingPointModel( FloatingPointModel model )
+{
+	mFloatingPointModel = model;
+	return *this;
+}
+BuildSettings& BuildSettings::favorSizeOrSpeed( FavorSizeOrSpeed favor )
+{
+	mFavorSizeOrSpeed = favor;
+	return *this;
+}
+BuildSettings& BuildSettings::intern()
+{
+	runtime::intern( &mIncludes );
+	runtime::intern( &mLibraryPaths );
+	runtime::intern( &mAdditionalSources );
+	runtime::intern( &mLibraries );
+	runtime::intern( &mPpDefinitions );
+	runtime::intern( &mForcedIncludes );
+	runtime::intern( &mCompilerOptions );
+	runtime::intern( &mLinkerOptions );
+	runtime::intern( &mObjPaths );
+	runtime::intern( &mUserMacros );
+	return *this;
+}
 BuildSettings& BuildSettings::outputPath( const ci::fs::path &path )
 {
 	mOutputPath = path;
@@ -383,6 +1094,11 @@ BuildSettings& BuildSettings::intermediatePath( const ci::fs::path &path )
 	mIntermediatePath = path;
 	return *this;
 }
+BuildSettings& BuildSettings::cacheDirectory( const ci::fs::path &directory )
+{
+	mCacheDirectory = directory;
+	return *this;
+}
 BuildSettings& BuildSettings::configuration( const std::string &option )
 {
 	mConfiguration = option;
@@ -406,24 +1122,30 @@ BuildSettings& BuildSettings::moduleName( const std::string &name )
 
 BuildSettings& BuildSettings::forceInclude( const std::string &filename )
 {
-	mForcedIncludes.push_back( filename );
+	mForcedIncludes.modify().push_back( filename );
 	return *this;
 }
 
 BuildSettings& BuildSettings::additionalSource( const ci::fs::path &cppFile )
 {
-	mAdditionalSources.push_back( cppFile );
+	mAdditionalSources.modify().push_back( cppFile );
 	return *this;
 }
 BuildSettings& BuildSettings::additionalSources( const std::vector<ci::fs::path> &cppFiles )
 {
-	mAdditionalSources.insert( mAdditionalSources.begin(), cppFiles.begin(), cppFiles.end() );
+	auto &sources = mAdditionalSources.modify();
+	sources.insert( sources.begin(), cppFiles.begin(), cppFiles.end() );
+	return *this;
+}
+BuildSettings& BuildSettings::unitySource( const ci::fs::path &cppFile )
+{
+	mUnitySource = cppFile;
 	return *this;
 }
 
 BuildSettings& BuildSettings::linkObj( const ci::fs::path &path )
 {
-	mObjPaths.push_back( path );
+	mObjPaths.modify().push_back( path );
 	return *this;
 }
 
@@ -435,13 +1157,13 @@ BuildSettings& BuildSettings::moduleDef( const ci::fs::path &path )
 	
 BuildSettings& BuildSettings::preBuildStep( const BuildStepRef &customStep ) 
 {
-	mPreBuildSteps.push_back( customStep );
+	mPreBuildSteps.modify().push_back( customStep );
 	return *this;
 }
 
 BuildSettings& BuildSettings::postBuildStep( const BuildStepRef &customStep ) 
 {
-	mPostBuildSteps.push_back( customStep );
+	mPostBuildSteps.modify().push_back( customStep );
 	return *this;
 }
 
@@ -24,16 +24,43 @@
 #include "runtime/BuildOutput.h"
 #include "runtime/Factory.h"
 #include "runtime/ProjectConfiguration.h"
+#include "runtime/Process.h"
 #include <fstream>
+#include <sstream>
 
 #include "cinder/app/App.h"
+#include "cinder/app/Platform.h"
+#include "cinder/Log.h"
 #include "cinder/Utilities.h"
 
+#if defined( CINDER_MSW )
+	#if ! defined( WIN32_LEAN_AND_MEAN )
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <Windows.h>
+#elif ! defined( CINDER_MAC )
+	#include <algorithm>
+	#include <link.h>
+#endif
+
 using namespace std;
 using namespace ci;
 
 namespace runtime {
 
+namespace {
+	// platform specific names of the files the compiler generates
+#if defined( CINDER_MSW )
+	const std::string sObjectExtension = ".obj";
+	const std::string sPrecompiledHeaderExtension = ".pch";
+	const std::string sExportDeclaration = "extern \"C\" __declspec(dllexport) void* __cdecl ";
+#else
+	const std::string sObjectExtension = ".o";
+	const std::string sPrecompiledHeaderExtension = "Pch.h.gch";
+	const std::string sExportDeclaration = "extern \"C\" __attribute__((visibility(\"default\"))) void* ";
+#endif
+} // anonymous namespace
+
 BuildStep::~BuildStep()
 {
 }
@@ -54,6 +81,12 @@ CodeGeneration::Options& CodeGeneration::Options::include( const std::string &fi
 	return *this;
 }
 
+CodeGeneration::Options& CodeGeneration::Options::unitySource( const ci::fs::path &path )
+{
+	mUnitySources.push_back( path );
+	return *this;
+}
+
 CodeGeneration::CodeGeneration( const Options &options )
 	: mOptions( options )
 {
@@ -62,6 +95,25 @@ CodeGeneration::CodeGeneration( const Options &options )
 void CodeGeneration::execute( BuildSettings* settings ) const
 {
 	fs::path outputPath = settings->getIntermediatePath() / "runtime" / settings->getModuleName() / ( settings->getModuleName() + "Factory.cpp" );
+
+	// unity build: the factory includes the module sources and is compiled alone, the heavy headers are only parsed once
+	if( ! mOptions.mUnitySources.empty() ) {
+		std::vector<fs::path> sources = mOptions.mUnitySources;
+		sources.insert( sources.end(), settings->getAdditionalSources().begin(), settings->getAdditionalSources().end() );
+		std::ostringstream source;
+		generateSource( source, *settings, sources );
+
+		// it's compiled every time anyway, but only rewrite it when it changes
+		ifstream input( outputPath, ios::binary );
+		const string currentSource( ( istreambuf_iterator<char>( input ) ), istreambuf_iterator<char>() );
+		input.close();
+		if( currentSource != source.str() ) {
+			ofstream( outputPath, ios::binary ) << source.str();
+		}
+		settings->unitySource( outputPath );
+		return;
+	}
+
 	bool generate = true;
 	if( fs::exists( outputPath ) ) {
 		// if the file already exists compare the number of lines
@@ -79,43 +131,51 @@ void CodeGeneration::execute( BuildSettings* settings ) const
 
 		// generate the source
 		std::ofstream outputFile( outputPath );
-		outputFile << "#include <new>" << endl;
-		for( const auto &inc : mOptions.mIncludes ) {
-			outputFile << "#include \"" << inc << "\"" << endl;
-		}
-		outputFile << endl;
+		generateSource( outputFile, *settings, {} );
+	}
+	else {
+		// update the linker build settings
+		settings->linkObj( outputPath.parent_path() / "build" / ( settings->getModuleName() + "Factory" + sObjectExtension ) );
+	}
+}
+
+void CodeGeneration::generateSource( std::ostream &outputFile, const BuildSettings &settings, const std::vector<ci::fs::path> &sources ) const
+{
+	outputFile << "#include <new>" << endl;
+	for( const auto &inc : mOptions.mIncludes ) {
+		outputFile << "#include \"" << inc << "\"" << endl;
+	}
+	for( const auto &source : sources ) {
+		outputFile << "#include \"" << source.generic_string() << "\"" << endl;
+	}
+	outputFile << endl;
 	
-		if( mOptions.mNewOperators.size() ) {
-			outputFile << "extern \"C\" __declspec(dllexport) void* __cdecl rt_" << settings->getModuleName() << "_new_operator( const std::string &className )" << endl;
-			outputFile << "{" << endl;
-			outputFile << "\tvoid* ptr;" << endl;
-			for( size_t i = 0; i < mOptions.mNewOperators.size(); ++i ) {
-				outputFile << "\t" << ( i > 0 ? "else if" : "if" ) << "( className == \"" << mOptions.mNewOperators[i] << "\" ) {" << endl;
-				outputFile << "\t\tptr = static_cast<void*>( ::new " << mOptions.mNewOperators[i] << "() );" << endl;
-				outputFile << "\t}" << endl;
-			}
-			outputFile << "\treturn ptr;" << endl;
-			outputFile << "}" << endl;
-			outputFile << endl;
+	if( mOptions.mNewOperators.size() ) {
+		outputFile << sExportDeclaration << "rt_" << settings.getModuleName() << "_new_operator( const std::string &className )" << endl;
+		outputFile << "{" << endl;
+		outputFile << "\tvoid* ptr;" << endl;
+		for( size_t i = 0; i < mOptions.mNewOperators.size(); ++i ) {
+			outputFile << "\t" << ( i > 0 ? "else if" : "if" ) << "( className == \"" << mOptions.mNewOperators[i] << "\" ) {" << endl;
+			outputFile << "\t\tptr = static_cast<void*>( ::new " << mOptions.mNewOperators[i] << "() );" << endl;
+			outputFile << "\t}" << endl;
 		}
+		outputFile << "\treturn ptr;" << endl;
+		outputFile << "}" << endl;
+		outputFile << endl;
+	}
 	
-		if( mOptions.mPlacementNewOperators.size() ) {
-			outputFile << "extern \"C\" __declspec(dllexport) void* __cdecl rt_" << settings->getModuleName() << "_placement_new_operator( const std::string &className, void* address )" << endl;
-			outputFile << "{" << endl;
-			outputFile << "\tvoid* ptr;" << endl;
-			for( size_t i = 0; i < mOptions.mPlacementNewOperators.size(); ++i ) {
-				outputFile << "\t" << ( i > 0 ? "else if" : "if" ) << "( className == \"" << mOptions.mPlacementNewOperators[i] << "\" ) {" << endl;
-				outputFile << "\t\tptr = static_cast<void*>( ::new (address) " << mOptions.mPlacementNewOperators[i] << "() );" << endl;
-				outputFile << "\t}" << endl;
-			}
-			outputFile << "\treturn ptr;" << endl;
-			outputFile << "}" << endl;
-			outputFile << endl;
+	if( mOptions.mPlacementNewOperators.size() ) {
+		outputFile << sExportDeclaration << "rt_" << settings.getModuleName() << "_placement_new_operator( const std::string &className, void* address )" << endl;
+		outputFile << "{" << endl;
+		outputFile << "\tvoid* ptr;" << endl;
+		for( size_t i = 0; i < mOptions.mPlacementNewOperators.size(); ++i ) {
+			outputFile << "\t" << ( i > 0 ? "else if" : "if" ) << "( className == \"" << mOptions.mPlacementNewOperators[i] << "\" ) {" << endl;
+			outputFile << "\t\tptr = static_cast<void*>( ::new (address) " << mOptions.mPlacementNewOperators[i] << "() );" << endl;
+			outputFile << "\t}" << endl;
 		}
-	}
-	else {
-		// update the linker build settings
-		settings->linkObj( outputPath.parent_path() / "build" / ( settings->getModuleName() + "Factory.obj" ) );
+		outputFile << "\treturn ptr;" << endl;
+		outputFile << "}" << endl;
+		outputFile << endl;
 	}
 }
 
@@ -169,7 +229,12 @@ void PrecompiledHeader::execute( BuildSettings* settings ) const
 {
 	auto outputHeader = settings->getIntermediatePath() / "runtime" / settings->getModuleName() / ( settings->getModuleName() + "Pch.h" ); 
 	auto outputCpp = settings->getIntermediatePath() / "runtime" / settings->getModuleName() / ( settings->getModuleName() + "Pch.cpp" ); 
-	auto outputPch = settings->getIntermediatePath() / "runtime" / settings->getModuleName() / "build" / ( settings->getModuleName() + ".pch" ); 
+#if defined( CINDER_MSW )
+	auto outputPch = settings->getIntermediatePath() / "runtime" / settings->getModuleName() / "build" / ( settings->getModuleName() + sPrecompiledHeaderExtension ); 
+#else
+	// gcc and clang look for the precompiled header next to the header
+	auto outputPch = settings->getIntermediatePath() / "runtime" / settings->getModuleName() / ( settings->getModuleName() + sPrecompiledHeaderExtension ); 
+#endif
 
 	// filter out ignored includes
 	mOptions.mIncludes.erase( remove_if( mOptions.mIncludes.begin(), mOptions.mIncludes.end(), [this](const std::string &filename) -> bool {
@@ -204,12 +269,16 @@ void PrecompiledHeader::execute( BuildSettings* settings ) const
 		settings->createPrecompiledHeader( true );
 		settings->usePrecompiledHeader( true );
 		settings->forceInclude( settings->getModuleName() + "Pch.h" );
-		settings->linkObj( settings->getIntermediatePath() / "runtime" / settings->getModuleName() / "build" / ( settings->getModuleName() + "Pch.obj" ) );
+#if defined( CINDER_MSW )
+		settings->linkObj( settings->getIntermediatePath() / "runtime" / settings->getModuleName() / "build" / ( settings->getModuleName() + "Pch" + sObjectExtension ) );
+#endif
 	}
 	else if( fs::exists( outputPch ) ) {
 		settings->usePrecompiledHeader( true );
 		settings->forceInclude( settings->getModuleName() + "Pch.h" );
-		settings->linkObj( settings->getIntermediatePath() / "runtime" / settings->getModuleName() / "build" / ( settings->getModuleName() + "Pch.obj" ) );
+#if defined( CINDER_MSW )
+		settings->linkObj( settings->getIntermediatePath() / "runtime" / settings->getModuleName() / "build" / ( settings->getModuleName() + "Pch" + sObjectExtension ) );
+#endif
 	}
 }
 
@@ -229,6 +298,7 @@ ModuleDefinition::Options& ModuleDefinition::Options::exportVftable( const std::
 std::string ModuleDefinition::getVftableSymbol( const std::string &typeName )
 {
 	auto parts = ci::split( typeName, "::" );
+#if defined( CINDER_MSW )
 	string decoratedName;
 	for( auto rIt = parts.rbegin(); rIt != parts.rend(); ++rIt ) {
 		if( ! rIt->empty() ) // handle leading "::" case, which results in any empty part
@@ -236,6 +306,19 @@ std::string ModuleDefinition::getVftableSymbol( const std::string &typeName )
 	}
 
 	return "??_7" + decoratedName + "@6B@";
+#else
+	// Itanium C++ ABI: turns 'MyClass' into '_ZTV7MyClass', or 'a::b::MyClass' into '_ZTVN1a1b7MyClassE'
+	string mangledName;
+	size_t numParts = 0;
+	for( const auto &part : parts ) {
+		if( ! part.empty() ) {
+			mangledName += to_string( part.size() ) + part;
+			++numParts;
+		}
+	}
+
+	return numParts > 1 ? "_ZTVN" + mangledName + "E" : "_ZTV" + mangledName;
+#endif
 }
 	
 ModuleDefinition::ModuleDefinition( const Options &options )
@@ -266,10 +349,10 @@ void ModuleDefinition::execute( BuildSettings* settings ) const
 void LinkAppObjs::execute( BuildSettings* settings ) const
 {
 	for( auto it = fs::directory_iterator( settings->getIntermediatePath() ), end = fs::directory_iterator(); it != end; it++ ) {
-		if( it->path().extension() == ".obj" ) {
+		if( it->path().extension() == sObjectExtension ) {
 			// Skip obj for current source or current app
-			if( it->path().filename().string().find( settings->getModuleName() + ".obj" ) == string::npos 
-				&& it->path().filename().string().find( ProjectConfiguration::instance().getProjectPath().stem().string() + "App.obj" ) == string::npos ) {
+			if( it->path().filename().string().find( settings->getModuleName() + sObjectExtension ) == string::npos 
+				&& it->path().filename().string().find( ProjectConfiguration::instance().getProjectPath().stem().string() + "App" + sObjectExtension ) == string::npos ) {
 				const Factory::Type* moduleType = nullptr;
 				for( const auto &type : Factory::instance().getTypes() ) {
 					if( it->path().stem().string().find( type.second.getName() ) != string::npos ) {
@@ -278,12 +361,23 @@ void LinkAppObjs::execute( BuildSettings* settings ) const
 					}
 				}
 
-				// check whether a more recent version exists
+				// check whether a more recent version exists. A unity build only produces the factory object, which includes
+				// the type's sources and exports functions named after its module. The objects can also be missing, ex. when
+				// the version was fetched from a cache entry stored without them
+				fs::path versionObj;
 				if( moduleType && moduleType->getModule() && moduleType->getModule()->getHandle() && ! moduleType->getVersions().empty() ) {
-					auto version = moduleType->getVersions().back();
-					settings->linkObj( version.getPath() / ( moduleType->getName() + ".obj" ) );
-					if( fs::exists( version.getPath() / ( moduleType->getName() + "Pch.obj" ) ) ) {
-						settings->linkObj( version.getPath() / ( moduleType->getName() + "Pch.obj" ) );
+					auto versionPath = moduleType->getVersions().back().getPath();
+					if( fs::exists( versionPath / ( moduleType->getName() + sObjectExtension ) ) ) {
+						versionObj = versionPath / ( moduleType->getName() + sObjectExtension );
+					}
+					else if( fs::exists( versionPath / ( moduleType->getName() + "Factory" + sObjectExtension ) ) ) {
+						versionObj = versionPath / ( moduleType->getName() + "Factory" + sObjectExtension );
+					}
+				}
+				if( ! versionObj.empty() ) {
+					settings->linkObj( versionObj );
+					if( fs::exists( versionObj.parent_path() / ( moduleType->getName() + "Pch" + sObjectExtension ) ) ) {
+						settings->linkObj( versionObj.parent_path() / ( moduleType->getName() + "Pch" + sObjectExtension ) );
 					}
 				}
 				// otherwise load the app version
@@ -295,6 +389,159 @@ void LinkAppObjs::execute( BuildSettings* settings ) const
 	}
 }
 
+namespace {
+#if defined( CINDER_MSW )
+	//! Symbol exported by the executable
+	struct Export {
+		std::string	mName;
+		bool		mData;
+	};
+
+	//! Returns the symbols exported by the running executable, read from its image in memory, and the machine it's built for
+	std::vector<Export> getExecutableExports( std::string* machine )
+	{
+		auto base = reinterpret_cast<const uint8_t*>( ::GetModuleHandleW( nullptr ) );
+		auto ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>( base + reinterpret_cast<const IMAGE_DOS_HEADER*>( base )->e_lfanew );
+		*machine = ntHeaders->FileHeader.Machine == IMAGE_FILE_MACHINE_AMD64 ? "X64" : ntHeaders->FileHeader.Machine == IMAGE_FILE_MACHINE_ARM64 ? "ARM64" : "X86";
+
+		std::vector<Export> exports;
+		const auto &directory = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+		if( ! directory.VirtualAddress || ! directory.Size ) {
+			return exports;
+		}
+		auto exportDirectory = reinterpret_cast<const IMAGE_EXPORT_DIRECTORY*>( base + directory.VirtualAddress );
+		auto names = reinterpret_cast<const DWORD*>( base + exportDirectory->AddressOfNames );
+		auto ordinals = reinterpret_cast<const WORD*>( base + exportDirectory->AddressOfNameOrdinals );
+		auto functions = reinterpret_cast<const DWORD*>( base + exportDirectory->AddressOfFunctions );
+		auto sections = IMAGE_FIRST_SECTION( ntHeaders );
+		for( DWORD i = 0; i < exportDirectory->NumberOfNames; ++i ) {
+			// the exports living in a section that isn't executable are variables, which the .def needs to know about
+			DWORD address = functions[ordinals[i]];
+			bool data = false;
+			for( WORD j = 0; j < ntHeaders->FileHeader.NumberOfSections; ++j ) {
+				if( address >= sections[j].VirtualAddress && address < sections[j].VirtualAddress + sections[j].Misc.VirtualSize ) {
+					data = ! ( sections[j].Characteristics & IMAGE_SCN_MEM_EXECUTE );
+					break;
+				}
+			}
+			exports.push_back( { reinterpret_cast<const char*>( base + names[i] ), data } );
+		}
+		return exports;
+	}
+
+	//! Returns the import library of the running executable, the one written by the linker next to it or one generated from its exports. 
+	//! Returns an empty path if the executable doesn't export anything
+	fs::path getExecutableImportLibrary( const fs::path &intermediatePath )
+	{
+		wchar_t modulePath[MAX_PATH];
+		::GetModuleFileNameW( nullptr, modulePath, MAX_PATH );
+		const fs::path executablePath( modulePath );
+
+		// the linker writes an import library next to the executable as soon as the app exports symbols with a .def file
+		auto importLibrary = executablePath.parent_path() / ( executablePath.stem().string() + ".lib" );
+		if( fs::exists( importLibrary ) ) {
+			return importLibrary;
+		}
+
+		// otherwise generate one from the exports of the executable, unless it's already up to date
+		importLibrary = intermediatePath / "runtime" / ( executablePath.stem().string() + ".lib" );
+		if( fs::exists( importLibrary ) && fs::last_write_time( importLibrary ) >= fs::last_write_time( executablePath ) ) {
+			return importLibrary;
+		}
+		std::string machine;
+		auto exports = getExecutableExports( &machine );
+		if( exports.empty() ) {
+			return fs::path();
+		}
+
+		auto defPath = fs::path( importLibrary ).replace_extension( ".def" );
+		fs::create_directories( defPath.parent_path() );
+		std::ofstream defFile( defPath );
+		defFile << "NAME \"" << executablePath.filename().string() << "\"" << endl;
+		defFile << "EXPORTS" << endl;
+		for( const auto &symbol : exports ) {
+			defFile << "\t" << symbol.mName << ( symbol.mData ? "\tDATA" : "" ) << endl;
+		}
+		defFile.close();
+		if( ! defFile ) {
+			CI_LOG_E( "Failed writing " << defPath );
+			return fs::path();
+		}
+
+		try {
+			Process process( { Compiler::instance().findExecutable( "lib.exe" ).string(), "/NOLOGO", "/MACHINE:" + machine, "/DEF:" + defPath.string(), "/OUT:" + importLibrary.string() }, 
+				Process::Options().redirectInput( false ).environment( Compiler::instance().getEnvironment() ) );
+			auto output = process.getOutputSync();
+			if( process.terminate() != 0 ) {
+				CI_LOG_E( "Failed generating the import library of " << executablePath.filename() << ":\n" << output );
+				std::error_code error;
+				fs::remove( importLibrary, error );
+				return fs::path();
+			}
+		}
+		catch( const ci::Exception &exc ) {
+			CI_LOG_E( "Failed generating the import library of " << executablePath.filename() << ": " << exc.what() );
+			return fs::path();
+		}
+		return importLibrary;
+	}
+#elif ! defined( CINDER_MAC )
+	//! Returns the number of functions defined in the dynamic symbol table of the running executable, the ones a shared library can be resolved against
+	size_t getNumExecutableDynamicFunctions()
+	{
+		std::ifstream file( "/proc/self/exe", ios::binary );
+		ElfW(Ehdr) header;
+		if( ! file.read( reinterpret_cast<char*>( &header ), sizeof( header ) ) || ! std::equal( header.e_ident, header.e_ident + SELFMAG, ELFMAG ) ) {
+			return 0;
+		}
+		std::vector<ElfW(Shdr)> sections( header.e_shnum );
+		file.seekg( header.e_shoff );
+		if( ! file.read( reinterpret_cast<char*>( sections.data() ), sections.size() * sizeof( ElfW(Shdr) ) ) ) {
+			return 0;
+		}
+		for( const auto &section : sections ) {
+			if( section.sh_type != SHT_DYNSYM || section.sh_entsize != sizeof( ElfW(Sym) ) ) {
+				continue;
+			}
+			std::vector<ElfW(Sym)> symbols( section.sh_size / section.sh_entsize );
+			file.seekg( section.sh_offset );
+			if( ! file.read( reinterpret_cast<char*>( symbols.data() ), symbols.size() * sizeof( ElfW(Sym) ) ) ) {
+				return 0;
+			}
+			return std::count_if( symbols.begin(), symbols.end(), []( const ElfW(Sym) &symbol ) {
+				return symbol.st_shndx != SHN_UNDEF && ELF64_ST_TYPE( symbol.st_info ) == STT_FUNC;
+			} );
+		}
+		return 0;
+	}
+#endif
+} // anonymous namespace
+
+void LinkAppExports::execute( BuildSettings* settings ) const
+{
+#if defined( CINDER_MSW )
+	auto importLibrary = getExecutableImportLibrary( settings->getIntermediatePath() );
+	if( ! importLibrary.empty() ) {
+		settings->library( importLibrary.string() );
+	}
+	else {
+		CI_LOG_W( "The app doesn't export any symbol, linking the app's .obj files instead. Export them with __declspec(dllexport), /EXPORT or a .def file" );
+		LinkAppObjs().execute( settings );
+	}
+#elif defined( CINDER_MAC )
+	// the app symbols are looked up in the executable when the module is loaded
+	settings->linkerOption( "-undefined" ).linkerOption( "dynamic_lookup" );
+#else
+	// shared libraries are allowed undefined symbols, they are resolved against the executable when the module is loaded
+	// as long as the app has been linked with -rdynamic
+	static const bool exportsSymbols = getNumExecutableDynamicFunctions() > 0;
+	if( ! exportsSymbols ) {
+		CI_LOG_W( "The app doesn't export any function, linking the app's object files instead. Link it with -rdynamic (ENABLE_EXPORTS with CMake)" );
+		LinkAppObjs().execute( settings );
+	}
+#endif
+}
+
 namespace {
 	fs::path getNextVersionPath( const ci::fs::path &path ) 
 	{
@@ -334,7 +581,7 @@ namespace {
 
 void CopyBuildOutput::execute( BuildSettings* settings ) const
 {
-	fs::path outputPath = settings->getOutputPath().empty() ? ( settings->getIntermediatePath() / "runtime" / settings->getModuleName() / "build" / ( settings->getModuleName() + ".dll" ) ) : settings->getOutputPath();
+	fs::path outputPath = settings->getOutputPath().empty() ? ( settings->getIntermediatePath() / "runtime" / settings->getModuleName() / "build" / ( settings->getModuleName() + Module::getExtension() ) ) : settings->getOutputPath();
 	// find and create the destination folder
 	mDestFolder = getNextVersionPath( outputPath );
 	if( ! fs::exists( mDestFolder ) ) {
@@ -345,6 +592,11 @@ void CopyBuildOutput::execute( BuildSettings* settings ) const
 
 void CopyBuildOutput::execute( BuildOutput* output ) const
 {
+	// modules linked in memory have nothing to copy
+	if( output->getSymbolLookup() ) {
+		return;
+	}
+
 	// copy build files to destination folder and edit BuildOutput
 	std::error_code copyError;
 	if( fs::exists( output->getOutputPath().parent_path() / ( output->getBuildSettings().getModuleName() + ".pdb" ) ) ) {
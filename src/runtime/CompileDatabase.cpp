@@ -0,0 +1,318 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "runtime/CompileDatabase.h"
+#include "runtime/JsonReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <mutex>
+
+#if defined( CINDER_MSW )
+	#if ! defined( WIN32_LEAN_AND_MEAN )
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+namespace {
+
+	//! Splits the "command" of an entry like a shell would, quotes grouping and backslashes escaping quotes, backslashes and whitespace
+	vector<string> splitCommand( const string &command )
+	{
+		vector<string> arguments;
+		string argument;
+		bool inArgument = false;
+		char quote = 0;
+		for( size_t i = 0; i < command.size(); ++i ) {
+			char c = command[i];
+			if( quote ) {
+				if( c == quote ) {
+					quote = 0;
+				}
+				else if( c == '\\' && quote == '"' && i + 1 < command.size() && ( command[i + 1] == '"' || command[i + 1] == '\\' ) ) {
+					argument.push_back( command[++i] );
+				}
+				else {
+					argument.push_back( c );
+				}
+			}
+			else if( std::isspace( static_cast<unsigned char>( c ) ) ) {
+				if( inArgument ) {
+					arguments.push_back( std::move( argument ) );
+					argument.clear();
+					inArgument = false;
+				}
+			}
+			else {
+				inArgument = true;
+				if( c == '"' || c == '\'' ) {
+					quote = c;
+				}
+				// windows paths keep their backslashes
+				else if( c == '\\' && i + 1 < command.size() && ( command[i + 1] == '"' || command[i + 1] == '\'' || command[i + 1] == '\\' || std::isspace( static_cast<unsigned char>( command[i + 1] ) ) ) ) {
+					argument.push_back( command[++i] );
+				}
+				else {
+					argument.push_back( c );
+				}
+			}
+		}
+		if( inArgument ) {
+			arguments.push_back( std::move( argument ) );
+		}
+		return arguments;
+	}
+
+	void unmapFile( const char* data, size_t size )
+	{
+#if defined( CINDER_MSW )
+		::UnmapViewOfFile( data );
+#else
+		::munmap( const_cast<char*>( data ), size );
+#endif
+	}
+
+	//! Returns the key of path in the indices
+	string getIndexKey( const fs::path &path )
+	{
+		auto key = path.lexically_normal().generic_string();
+#if defined( CINDER_MSW )
+		std::transform( key.begin(), key.end(), key.begin(), []( char c ) { return static_cast<char>( std::tolower( static_cast<unsigned char>( c ) ) ); } );
+#endif
+		return key;
+	}
+
+} // anonymous namespace
+
+CompileDatabase::CompileDatabase( const fs::path &path )
+	: mPath( path )
+{
+	const char* mappedData = nullptr;
+	size_t mappedSize = 0;
+
+	// map the file
+#if defined( CINDER_MSW )
+	HANDLE file = ::CreateFileW( path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( file == INVALID_HANDLE_VALUE ) {
+		throw CompileDatabaseException( "Failed to open the compilation database " + path.string() );
+	}
+	LARGE_INTEGER size;
+	if( ::GetFileSizeEx( file, &size ) && size.QuadPart > 0 ) {
+		if( HANDLE mapping = ::CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr ) ) {
+			mappedData = static_cast<const char*>( ::MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) );
+			mappedSize = mappedData ? static_cast<size_t>( size.QuadPart ) : 0;
+			// the view keeps the mapping alive
+			::CloseHandle( mapping );
+		}
+	}
+	::CloseHandle( file );
+#else
+	int file = ::open( path.c_str(), O_RDONLY );
+	if( file < 0 ) {
+		throw CompileDatabaseException( "Failed to open the compilation database " + path.string() );
+	}
+	struct stat status;
+	if( ::fstat( file, &status ) == 0 && status.st_size > 0 ) {
+		void* data = ::mmap( nullptr, static_cast<size_t>( status.st_size ), PROT_READ, MAP_PRIVATE, file, 0 );
+		if( data != MAP_FAILED ) {
+			mappedData = static_cast<const char*>( data );
+			mappedSize = static_cast<size_t>( status.st_size );
+		}
+	}
+	::close( file );
+#endif
+	if( ! mappedData ) {
+		throw CompileDatabaseException( "Failed to map the compilation database " + path.string() );
+	}
+
+	// index the entries by file, only reading their "directory" and "file"
+	try {
+		JsonReader reader( mPath, mappedData, mappedSize );
+		reader.expect( '[' );
+		if( ! reader.skip( ']' ) ) {
+			string directory, file, key;
+			do {
+				reader.peek();
+				Entry entry = { reader.getPosition(), 0 };
+				directory.clear();
+				file.clear();
+				reader.expect( '{' );
+				if( ! reader.skip( '}' ) ) {
+					do {
+						key.clear();
+						reader.readString( &key );
+						reader.expect( ':' );
+						if( key == "directory" ) {
+							reader.readString( &directory );
+						}
+						else if( key == "file" ) {
+							reader.readString( &file );
+						}
+						else {
+							reader.skipValue();
+						}
+					} while( reader.skip( ',' ) );
+					reader.expect( '}' );
+				}
+				entry.mEnd = reader.getPosition();
+
+				if( ! file.empty() ) {
+					auto filePath = fs::path( file ).is_absolute() ? fs::path( file ) : fs::path( directory ) / file;
+					// the first command of a file is the one used, as clang tools do. Only the text of the entries indexed is kept
+					const Entry copy = { mEntries.size(), mEntries.size() + entry.mEnd - entry.mBegin };
+					bool indexed = mIndex.emplace( getIndexKey( filePath ), copy ).second;
+					indexed = mDirectoryIndex.emplace( getIndexKey( filePath.parent_path() ), copy ).second || indexed;
+					if( indexed ) {
+						mEntries.append( mappedData + entry.mBegin, entry.mEnd - entry.mBegin );
+					}
+				}
+			} while( reader.skip( ',' ) );
+			reader.expect( ']' );
+		}
+	}
+	catch( const JsonReaderException &exc ) {
+		unmapFile( mappedData, mappedSize );
+		throw CompileDatabaseException( string( "Invalid compilation database " ) + exc.what() );
+	}
+	catch( ... ) {
+		unmapFile( mappedData, mappedSize );
+		throw;
+	}
+	unmapFile( mappedData, mappedSize );
+}
+
+CompileDatabase::~CompileDatabase()
+{
+}
+
+CompileDatabaseRef CompileDatabase::load( const fs::path &path )
+{
+	struct Loaded {
+		CompileDatabaseRef	mDatabase;
+		int64_t				mWriteTime;
+		uintmax_t			mSize;
+	};
+	static std::mutex mutex;
+	static std::map<fs::path, Loaded> databases;
+
+	std::error_code error;
+	auto writeTime = static_cast<int64_t>( fs::last_write_time( path, error ).time_since_epoch().count() );
+	auto size = fs::file_size( path, error );
+
+	std::lock_guard<std::mutex> lock( mutex );
+	auto &loaded = databases[path];
+	if( ! loaded.mDatabase || loaded.mWriteTime != writeTime || loaded.mSize != size ) {
+		loaded = { std::make_shared<CompileDatabase>( path ), writeTime, size };
+	}
+	return loaded.mDatabase;
+}
+
+const CompileDatabase::Entry* CompileDatabase::findEntry( const fs::path &file ) const
+{
+	auto filePath = fs::absolute( file );
+	auto entry = mIndex.find( getIndexKey( filePath ) );
+	if( entry != mIndex.end() ) {
+		return &entry->second;
+	}
+	entry = mDirectoryIndex.find( getIndexKey( filePath.parent_path() ) );
+	if( entry != mDirectoryIndex.end() ) {
+		return &entry->second;
+	}
+	return nullptr;
+}
+
+bool CompileDatabase::findCommand( const fs::path &file, Command* command ) const
+{
+	auto entry = findEntry( file );
+	if( ! entry ) {
+		return false;
+	}
+	try {
+		readCommand( entry->mBegin, command );
+	}
+	catch( const JsonReaderException &exc ) {
+		throw CompileDatabaseException( string( "Invalid compilation database " ) + exc.what() );
+	}
+	return true;
+}
+
+void CompileDatabase::readCommand( size_t begin, Command* command ) const
+{
+	JsonReader reader( mPath, mEntries.data(), mEntries.size(), begin );
+	string key, value;
+	*command = Command();
+	reader.expect( '{' );
+	if( reader.skip( '}' ) ) {
+		return;
+	}
+	do {
+		key.clear();
+		reader.readString( &key );
+		reader.expect( ':' );
+		if( key == "directory" || key == "file" || key == "command" ) {
+			value.clear();
+			reader.readString( &value );
+			if( key == "directory" ) {
+				command->mDirectory = value;
+			}
+			else if( key == "file" ) {
+				command->mFile = value;
+			}
+			// "arguments" is preferred when both are present
+			else if( command->mArguments.empty() ) {
+				command->mArguments = splitCommand( value );
+			}
+		}
+		else if( key == "arguments" ) {
+			command->mArguments.clear();
+			reader.expect( '[' );
+			if( ! reader.skip( ']' ) ) {
+				do {
+					command->mArguments.emplace_back();
+					reader.readString( &command->mArguments.back() );
+				} while( reader.skip( ',' ) );
+				reader.expect( ']' );
+			}
+		}
+		else {
+			reader.skipValue();
+		}
+	} while( reader.skip( ',' ) );
+	reader.expect( '}' );
+
+	if( command->mFile.is_relative() ) {
+		command->mFile = command->mDirectory / command->mFile;
+	}
+}
+
+} // namespace runtime
@@ -1,70 +1,671 @@
 #include "runtime/CompilerBase.h"
+#include "runtime/BuildCache.h"
+#include "runtime/BuildLog.h"
 #include "runtime/Process.h"
 
 #include "cinder/app/App.h"
 #include "cinder/Filesystem.h"
+#include "cinder/Utilities.h"
+#include "cinder/Log.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <set>
+#include <thread>
+
+#include <cctype>
 
 using namespace std;
 using namespace ci;
 
 namespace runtime {
 
-namespace {
-	inline std::string removeEndline( const std::string &input ) 
-	{ 
-		auto output = input;
-		while( output.size() && ( output.back() == '\n' ) ) output = output.substr( 0, output.length() - 1 );
-		return output;
-	}
-	inline std::string removeCarriageReturn( const std::string &input ) 
-	{ 
-		auto output = input;
-		while( output.size() && ( output.back() == '\r' ) ) output = output.substr( 0, output.length() - 1 );
-		return output;
-	}
-	inline std::string quote( const std::string &input ) { return "\"" + input + "\""; };
+CompilerBase::Job::Job( BuildId buildId, const std::vector<std::string> &arguments, const std::function<void(const Job&)> &onFinish )
+	: mBuildId( buildId ), mArguments( arguments ), mExitCode( -1 ), mHashOutput( false ), mStartTime( std::chrono::steady_clock::now() ), mDuration( 0 ), mOnFinish( onFinish )
+{
+}
+
+CompilerBase::Job::~Job()
+{
 }
 
 CompilerBase::CompilerBase()
-	: mVerbose( false )
+	: mNextBuildId( 0 ), mLastDispatchedBuildId( 0 ), mNumWorkers( std::max( 1u, std::thread::hardware_concurrency() ) ), mVerbose( false )
 {
 }
 
 CompilerBase::~CompilerBase()
 {
+	// make sure no process outlives the compiler
+	for( const auto &job : mJobs ) {
+		job->mProcess->kill();
+	}
+}
+
+CompilerBase::BuildId CompilerBase::build( const std::string &arguments, const std::function<void( const BuildOutput& )> &onBuildFinish )
+{
+	// issue the command line as a build made of a single task
+	auto buildId = generateBuildId();
+	Build &build = mBuilds[buildId] = { BuildOutput(), onBuildFinish, {}, {}, 1, 0, 1, false, 0, "", false, false };
+	build.mTasks.push_back( { "command", { arguments }, {}, 0, false, 0 } );
+	try {
+		startShellJob( buildId, arguments, [this, buildId]( const Job &job ) { taskFinished( buildId, 0, job ); } );
+	}
+	catch( const CompilerException & ) {
+		mBuilds.erase( buildId );
+		throw;
+	}
+	return buildId;
 }
 
-void CompilerBase::parseProcessOutput()
+CompilerBase::BuildId CompilerBase::build( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::function<void(const BuildOutput&)> &onBuildFinish )
 {
-	string fullOutput;
-	while( mProcess->isOutputAvailable() ) {
-		auto output = removeEndline( mProcess->getOutputAsync() );
-		if( output.find( "error" ) != string::npos ) { 
-			mErrors.push_back( output );	
+	// prepare compilation results
+	BuildOutput output;
+	output.getFilePaths().push_back( sourcePath );
+
+	auto buildDir = settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build";
+	if( ! fs::exists( buildDir ) ) {
+		fs::create_directories( buildDir );
+	}
+
+	// execute pre build steps
+	auto buildSettings = settings;
+	for( const auto &buildStep : settings.mPreBuildSteps ) {
+		buildStep->execute( &buildSettings );
+	}
+		
+	// build the graph of jobs: the precompiled header first, then every translation unit in parallel, then the linker
+	Build build = { BuildOutput(), onBuildFinish, {}, {}, 0, 0, buildSettings.mNumParallelJobs, false, 0, "", false, false };
+	// a unity source includes all the others and is compiled alone
+	std::vector<ci::fs::path> sources = { sourcePath };
+	sources.insert( sources.end(), buildSettings.mAdditionalSources.begin(), buildSettings.mAdditionalSources.end() );
+	if( ! buildSettings.mUnitySource.empty() ) {
+		sources = { buildSettings.mUnitySource };
+	}
+
+	// with a cache, the translation units are preprocessed first and nothing gets compiled if the cache has the result
+	std::vector<size_t> compilerDependencies;
+	if( ! buildSettings.mCacheDirectory.empty() ) {
+		for( const auto &path : sources ) {
+			compilerDependencies.push_back( addTask( &build, path.filename().string() + " (preprocessor)", generatePreprocessorArgs( path, buildSettings ), {} ) );
+			build.mTasks.back().mPreprocessor = true;
+		}
+		build.mNumPreprocessorTasks = sources.size();
+	}
+	if( buildSettings.mCreatePch ) {
+		compilerDependencies.push_back( addTask( &build, buildSettings.getModuleName() + "Pch.cpp", generatePrecompiledHeaderArgs( buildSettings, &output ), {} ) );
+	}
+	std::vector<size_t> compilerTasks;
+	for( const auto &path : sources ) {
+		compilerTasks.push_back( addTask( &build, path.filename().string(), generateCompilerArgs( path, buildSettings, &output ), compilerDependencies ) );
+	}
+	output.getFilePaths().insert( output.getFilePaths().end(), buildSettings.mAdditionalSources.begin(), buildSettings.mAdditionalSources.end() );
+	auto linkerArgs = generateLinkerArgs( sourcePath, buildSettings, &output );
+	if( ! linkerArgs.empty() ) {
+		addTask( &build, output.getOutputPath().filename().string(), linkerArgs, compilerTasks );
+	}
+	output.setBuildSettings( buildSettings );
+	build.mOutput = output;
+
+	if( settings.isVerboseEnabled() ) {
+		for( const auto &task : build.mTasks ) {
+			string command;
+			for( const auto &arg : task.mArguments ) {
+				command += arg + " ";
+			}
+			CI_LOG_I( "command:\n" << command );
 		}
-		else if( output.find( "warning" ) != string::npos ) {
-			mWarnings.push_back( output );
+	}
+
+	auto buildId = generateBuildId();
+	mBuilds[buildId] = std::move( build );
+	RT_BUILD_LOG( BuildLog::Category::Info, "\n1>------ Runtime Compiler Build started: " << getBuildDescription() << " ------\n1>  " << sourcePath.filename() );
+	dispatchTasks();
+	return buildId;
+}
+
+CompilerBase::BuildId CompilerBase::prebuild( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::function<void(const BuildOutput&)> &onBuildFinish )
+{
+	BuildOutput output;
+	output.getFilePaths().push_back( sourcePath );
+
+	auto buildDir = settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build";
+	if( ! fs::exists( buildDir ) ) {
+		fs::create_directories( buildDir );
+	}
+
+	// the steps generate the sources, the module definition and the precompiled header sources
+	auto buildSettings = settings;
+	for( const auto &buildStep : settings.mPreBuildSteps ) {
+		buildStep->execute( &buildSettings );
+	}
+	if( ! buildSettings.mCreatePch ) {
+		return 0;
+	}
+
+	Build build = { BuildOutput(), onBuildFinish, {}, {}, 0, 0, buildSettings.mNumParallelJobs, false, 0, "", false, true };
+	addTask( &build, buildSettings.getModuleName() + "Pch.cpp", generatePrecompiledHeaderArgs( buildSettings, &output ) );
+	output.setBuildSettings( buildSettings );
+	build.mOutput = output;
+
+	auto buildId = generateBuildId();
+	mBuilds[buildId] = std::move( build );
+	RT_BUILD_LOG( BuildLog::Category::Info, "\n1>------ Runtime Compiler Prebuild started: " << getBuildDescription() << " ------\n1>  " << sourcePath.filename() );
+	dispatchTasks();
+	return buildId;
+}
+
+CompilerBase::BuildId CompilerBase::build( const std::vector<ci::fs::path> &sourcesPaths, const BuildSettings &settings, const std::function<void( const BuildOutput& )> &onBuildFinish )
+{
+	if( sourcesPaths.size() > 1 ) {
+		BuildSettings buildSettings = settings;
+		for( size_t i = 1; i < sourcesPaths.size(); ++i ) {
+			buildSettings.additionalSource( sourcesPaths[i] );
 		}
-		fullOutput += output;
+		return build( sourcesPaths.front(), buildSettings, onBuildFinish );
+	}
+	else if( sourcesPaths.size() > 0 ) {
+		return build( sourcesPaths.front(), settings, onBuildFinish );
+	}
+	return 0;
+}
+
+void CompilerBase::cancel( BuildId buildId )
+{
+	if( mBuilds.erase( buildId ) ) {
+		cancelJobs( buildId );
+		BuildLog::instance().write( BuildLog::Category::Info, "========== Runtime Compiler Build: 0 succeeded, 0 failed, 0 up-to-date, 1 skipped ==========" );
+		dispatchTasks();
 	}
-	if( mVerbose && ! fullOutput.empty() ) app::console() << fullOutput << endl;
 }
 
-void CompilerBase::initializeProcess()
+void CompilerBase::debugLog( BuildSettings *settings ) const
 {
-	if( fs::exists( getCompilerPath() ) ) {
+	CI_LOG_I( "Compiler Settings: " << printToString() );
+
+	if( settings ) {
+		CI_LOG_I( "BuildSettings: " << settings->printToString() );
+	}
+}
+
+std::vector<std::string> CompilerBase::captureEnvironment() const
+{
+	return Process::getEnvironment();
+}
+
+const std::vector<std::string>& CompilerBase::getEnvironment() const
+{
+	if( ! mEnvironment.valid() ) {
+		throw CompilerException( "Compiler Environment not initialized" );
+	}
+	return mEnvironment.get();
+}
 		
-		// create a command line process with the right environment variables and paths
-		mProcess = make_unique<Process>( getCLInitCommand(), getCLInitPath().string(), true, true );
+ci::fs::path CompilerBase::findExecutable( const std::string &name ) const
+{
+	auto executableIt = mExecutables.find( name );
+	if( executableIt != mExecutables.end() ) {
+		return executableIt->second;
+	}
 		
-		// start the compiler process
-		mProcess << quote( getCompilerPath().string() ) + " " + getCompilerInitArgs() << endl;
+#if defined( CINDER_MSW )
+	const char separator = ';';
+#else
+	const char separator = ':';
+#endif
+	for( const auto &variable : getEnvironment() ) {
+		// the PATH variable name is case insensitive on windows
+		if( variable.size() < 5 || variable[4] != '=' || ! std::equal( variable.begin(), variable.begin() + 4, "PATH", []( char a, char b ) { return toupper( a ) == b; } ) ) {
+			continue;
+		}
+		for( const auto &directory : ci::split( variable.substr( 5 ), separator ) ) {
+			if( ! directory.empty() && fs::exists( fs::path( directory ) / name ) ) {
+				return mExecutables[name] = fs::path( directory ) / name;
+			}
+		}
+	}
 		
-		// Connect the process redirection to cinder's console
-		mProcessOutputConnection = app::App::get()->getSignalUpdate().connect( bind( &CompilerBase::parseProcessOutput, this ) );
+	throw CompilerException( "Failed finding " + name + " in the Compiler Environment" );
+}
+
+void CompilerBase::setNumWorkers( size_t numWorkers )
+{
+	mNumWorkers = std::max<size_t>( 1, numWorkers );
+	dispatchTasks();
+}
+
+void CompilerBase::initializeJobs()
+{
+	// capturing the environment can take a while, do it in the background and only wait for it when the first job starts
+	mEnvironment = std::async( std::launch::async, [this]() { return captureEnvironment(); } ).share();
+	mUpdateConnection = app::App::get()->getSignalUpdate().connect( bind( &CompilerBase::updateJobs, this ) );
+}
+
+CompilerBase::BuildId CompilerBase::generateBuildId()
+{
+	return ++mNextBuildId;
+}
+
+void CompilerBase::startJob( BuildId buildId, const std::vector<std::string> &args, const std::function<void(const Job&)> &onFinish, bool hashOutput )
+{
+	auto job = make_unique<Job>( buildId, args, onFinish );
+	job->mHashOutput = hashOutput;
+	if( ! fs::path( args.front() ).is_absolute() ) {
+		job->mArguments.front() = findExecutable( args.front() ).string();
+	}
+	if( mVerbose && BuildLog::instance().isEnabled( BuildLog::Category::Verbose ) ) {
+		string command;
+		for( const auto &arg : job->mArguments ) {
+			command += arg + " ";
+		}
+		BuildLog::instance().write( BuildLog::Category::Verbose, std::move( command ) );
+	}
+
+	// the jobs are scheduled as their build asks, to leave room for the app
+	auto options = Process::Options().path( getWorkingDirectory().string() ).redirectInput( false ).environment( getEnvironment() );
+	auto buildIt = mBuilds.find( buildId );
+	if( buildIt != mBuilds.end() ) {
+		const auto &settings = buildIt->second.mOutput.getBuildSettings();
+		options.priority( settings.getJobPriority() ).affinity( settings.getJobAffinity() );
+	}
+
+	try {
+		job->mProcess = make_unique<Process>( job->mArguments, options );
+	}
+	catch( const ProcessExc &exc ) {
+		throw CompilerException( string( exc.what() ) + " " + job->mArguments.front() );
+	}
+	mJobs.push_back( std::move( job ) );
+}
+
+void CompilerBase::startShellJob( BuildId buildId, const std::string &commandLine, const std::function<void(const Job&)> &onFinish )
+{
+	auto job = make_unique<Job>( buildId, std::vector<std::string>( { commandLine } ), onFinish );
+	if( mVerbose && BuildLog::instance().isEnabled( BuildLog::Category::Verbose ) ) {
+		BuildLog::instance().write( BuildLog::Category::Verbose, commandLine );
+	}
+
+	try {
+#if defined( CINDER_MSW )
+		job->mProcess = make_unique<Process>( "cmd /c " + commandLine, Process::Options().path( getWorkingDirectory().string() ).redirectInput( false ).environment( getEnvironment() ) );
+#else
+		job->mProcess = make_unique<Process>( commandLine, Process::Options().path( getWorkingDirectory().string() ).redirectInput( false ).environment( getEnvironment() ) );
+#endif
+	}
+	catch( const ProcessExc &exc ) {
+		throw CompilerException( string( exc.what() ) + " " + commandLine );
+	}
+	mJobs.push_back( std::move( job ) );
+}
+
+void CompilerBase::cancelJobs( BuildId buildId )
+{
+	for( auto it = mJobs.begin(); it != mJobs.end(); ) {
+		if( (*it)->mBuildId == buildId ) {
+			(*it)->mProcess->kill();
+			(*it)->mProcess->terminate();
+			it = mJobs.erase( it );
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void CompilerBase::parseJobOutput( Job* job, std::string_view line )
+{
+	fs::path header;
+	if( parseDependency( line, &header ) ) {
+		if( ! header.empty() ) {
+			job->mDependencies.push_back( header );
+		}
+		return;
+	}
+	if( parseProfile( line, &job->mProfile ) ) {
+		return;
+	}
+
+	Diagnostic diagnostic;
+	if( Diagnostic::parse( line, &diagnostic ) ) {
+		if( diagnostic.isError() ) {
+			job->mErrors.emplace_back( line );
+		}
+		else if( diagnostic.isWarning() ) {
+			job->mWarnings.emplace_back( line );
+		}
+		job->mDiagnostics.push_back( std::move( diagnostic ) );
+	}
+	if( mVerbose ) RT_BUILD_LOG( BuildLog::Category::Verbose, line );
+}
+
+void CompilerBase::updateJobs()
+{
+	std::vector<std::unique_ptr<Job>> finishedJobs;
+	for( auto it = mJobs.begin(); it != mJobs.end(); ) {
+		Job* job = it->get();
+		// check the exit status first so that everything the process wrote is read below
+		bool running = job->mProcess->isRunning();
+		if( job->mHashOutput ) {
+			job->mProcess->readOutputLines( [job]( std::string_view line ) { job->mOutputHash.update( line ).update( "\n" ); } );
+		}
+		else {
+			job->mProcess->readOutputLines( [this, job]( std::string_view line ) { parseJobOutput( job, line ); } );
+		}
+		job->mProcess->readErrorLines( [this, job]( std::string_view line ) { parseJobOutput( job, line ); } );
+
+		if( ! running && job->mProcess->isOutputClosed() && job->mProcess->isErrorClosed() ) {
+			job->mExitCode = job->mProcess->terminate();
+			job->mDuration = std::chrono::steady_clock::now() - job->mStartTime;
+			finishedJobs.push_back( std::move( *it ) );
+			it = mJobs.erase( it );
+		}
+		else {
+			++it;
+		}
+	}
+
+	// callbacks are issued once the list is up to date as they are likely to start new jobs
+	for( const auto &job : finishedJobs ) {
+		if( job->mOnFinish ) {
+			job->mOnFinish( *job );
+		}
+	}
+
+	// and the workers freed by the finished and cancelled jobs are handed to the builds waiting for one
+	if( ! finishedJobs.empty() ) {
+		dispatchTasks();
+	}
+}
+
+size_t CompilerBase::addTask( Build* build, const std::string &name, const std::vector<std::string> &args, const std::vector<size_t> &dependencies )
+{
+	size_t taskIndex = build->mTasks.size();
+	build->mTasks.push_back( { name, args, {}, dependencies.size(), false, 0 } );
+	for( size_t dependency : dependencies ) {
+		build->mTasks[dependency].mDependents.push_back( taskIndex );
+	}
+	if( dependencies.empty() ) {
+		build->mReadyTasks.push_back( taskIndex );
+	}
+	return taskIndex;
+}
+
+void CompilerBase::dispatchTasks()
+{
+	while( mJobs.size() < mNumWorkers && ! mBuilds.empty() ) {
+		// look for a build with a task ready to start, beginning with the one following the last build served
+		auto buildIt = mBuilds.upper_bound( mLastDispatchedBuildId );
+		bool found = false;
+		for( size_t i = 0; i < mBuilds.size() && ! found; ++i ) {
+			if( buildIt == mBuilds.end() ) {
+				buildIt = mBuilds.begin();
+			}
+			const Build &build = buildIt->second;
+			found = ! build.mReadyTasks.empty() && ( ! build.mMaxJobs || build.mNumRunningJobs < build.mMaxJobs );
+			if( ! found ) {
+				++buildIt;
+			}
+		}
+		if( ! found ) {
+			return;
+		}
+
+		BuildId buildId = buildIt->first;
+		Build &build = buildIt->second;
+		size_t taskIndex = build.mReadyTasks.front();
+		build.mReadyTasks.pop_front();
+		mLastDispatchedBuildId = buildId;
+		try {
+			startJob( buildId, build.mTasks[taskIndex].mArguments, [this, buildId, taskIndex]( const Job &job ) { taskFinished( buildId, taskIndex, job ); }, build.mTasks[taskIndex].mPreprocessor );
+			build.mNumRunningJobs++;
+		}
+		catch( const CompilerException &exc ) {
+			build.mOutput.getErrors().push_back( exc.what() );
+			build.mFailed = true;
+			cancelJobs( buildId );
+			buildFinished( buildId );
+		}
+	}
+}
+
+void CompilerBase::taskFinished( BuildId buildId, size_t taskIndex, const Job &job )
+{
+	auto buildIt = mBuilds.find( buildId );
+	if( buildIt == mBuilds.end() ) {
+		return;
+	}
+
+	Build &build = buildIt->second;
+	build.mNumRunningJobs--;
+	build.mNumFinishedTasks++;
+	build.mOutput.getJobTimings().push_back( { build.mTasks[taskIndex].mName, job.getDuration() } );
+
+	auto &errors = build.mOutput.getErrors();
+	auto &warnings = build.mOutput.getWarnings();
+	errors.insert( errors.end(), job.getErrors().begin(), job.getErrors().end() );
+	warnings.insert( warnings.end(), job.getWarnings().begin(), job.getWarnings().end() );
+	auto &diagnostics = build.mOutput.getDiagnostics();
+	diagnostics.insert( diagnostics.end(), job.getDiagnostics().begin(), job.getDiagnostics().end() );
+	
+	if( ! job.succeeded() ) {
+		if( job.getErrors().empty() ) {
+			errors.push_back( fs::path( job.getArguments().front() ).filename().string() + " exited with code " + to_string( job.getExitCode() ) );
+		}
+		// the build is already lost, don't wait for the other translation units
+		build.mFailed = true;
+		cancelJobs( buildId );
+		buildFinished( buildId );
+		return;
+	}
+
+	// keep track of the headers compiled, for the types sharing them to be rebuilt when they change
+	if( ! build.mTasks[taskIndex].mPreprocessor ) {
+		auto &dependencies = build.mOutput.getDependencies();
+		auto dependenciesFile = readDependencies( job );
+		dependencies.insert( dependencies.end(), job.getDependencies().begin(), job.getDependencies().end() );
+		dependencies.insert( dependencies.end(), dependenciesFile.begin(), dependenciesFile.end() );
+
+		if( build.mOutput.getBuildSettings().isCompilerProfilingEnabled() ) {
+			build.mOutput.getCompilerProfile().merge( job.getProfile() );
+			readProfile( job, &build.mOutput.getCompilerProfile() );
+		}
+	}
+
+	// once every translation unit has been preprocessed the cache can tell whether compiling is needed at all
+	if( build.mTasks[taskIndex].mPreprocessor ) {
+		build.mTasks[taskIndex].mOutputHash = job.getOutputHash();
+		if( --build.mNumPreprocessorTasks == 0 && fetchFromCache( &build ) ) {
+			build.mCached = true;
+			build.mReadyTasks.clear();
+		}
+	}
+
+	if( ! build.mCached ) {
+		for( size_t dependent : build.mTasks[taskIndex].mDependents ) {
+			if( --build.mTasks[dependent].mNumDependencies == 0 ) {
+				build.mReadyTasks.push_back( dependent );
+			}
+		}
+	}
+	// a cached build only waits for the precompiled header, if it was being generated, to not leave it half written
+	if( build.mNumFinishedTasks == build.mTasks.size() || ( build.mCached && ! build.mNumRunningJobs ) ) {
+		buildFinished( buildId );
+	}
+}
+
+std::string CompilerBase::generateCacheKey( const Build &build ) const
+{
+	const auto &settings = build.mOutput.getBuildSettings();
+	Hash hash;
+	for( const auto &task : build.mTasks ) {
+		if( task.mPreprocessor ) {
+			hash.update( task.mOutputHash );
+		}
+	}
+
+	// what the preprocessed sources don't capture
+	for( const auto &options : { settings.mPpDefinitions, settings.mCompilerOptions, settings.mLinkerOptions, settings.mLibraries } ) {
+		for( const auto &option : options ) {
+			hash.update( option ).update( "\n" );
+		}
+	}
+	for( const auto &path : settings.mLibraryPaths ) {
+		hash.update( path.generic_string() ).update( "\n" );
+	}
+	hash.update( settings.mModuleName ).update( "\n" ).update( settings.mConfiguration ).update( "\n" ).update( settings.mPlatform ).update( "\n" );
+	for( auto codeGeneration : { static_cast<int>( settings.mOptimization ), static_cast<int>( settings.mIntrinsicFunctions ), static_cast<int>( settings.mInlineFunctionExpansion ),
+		static_cast<int>( settings.mEnhancedInstructionSet ), static_cast<int>( settings.mFloatingPointModel ), static_cast<int>( settings.mFavorSizeOrSpeed ) } ) {
+		hash.update( static_cast<uint64_t>( codeGeneration ) );
+	}
+	// the module definition is generated before every build, only its content matters
+	if( ! settings.mModuleDefPath.empty() ) {
+		std::ifstream moduleDef( settings.mModuleDefPath, std::ios::binary );
+		hash.update( std::string( std::istreambuf_iterator<char>( moduleDef ), std::istreambuf_iterator<char>() ) );
+	}
+
+	// the objects linked and the tools can change without the sources changing
+	auto stamp = [&hash]( const fs::path &path ) {
+		std::error_code error;
+		hash.update( path.generic_string() );
+		hash.update( static_cast<uint64_t>( fs::file_size( path, error ) ) );
+		hash.update( static_cast<uint64_t>( fs::last_write_time( path, error ).time_since_epoch().count() ) );
+	};
+	for( const auto &obj : settings.mObjPaths ) {
+		stamp( obj );
+	}
+	std::set<std::string> tools;
+	for( const auto &task : build.mTasks ) {
+		tools.insert( task.mArguments.front() );
+	}
+	for( const auto &tool : tools ) {
+		stamp( fs::path( tool ).is_absolute() ? fs::path( tool ) : findExecutable( tool ) );
+	}
+	
+	return hash.toString();
+}
+
+namespace {
+	//! Returns the files of output stored in the build cache: the module, its pdb and import library, and the objects it compiled
+	//! which LinkAppObjs links into the other modules. The objects linked from elsewhere aren't part of the entry
+	std::vector<ci::fs::path> getCacheFilePaths( const BuildOutput &output )
+	{
+		std::vector<ci::fs::path> paths = { output.getOutputPath() };
+		if( ! output.getPdbFilePath().empty() ) {
+			paths.push_back( output.getPdbFilePath() );
+		}
+		// import library of windows dlls
+		paths.push_back( ci::fs::path( output.getOutputPath() ).replace_extension( ".lib" ) );
+
+		const auto &settings = output.getBuildSettings();
+		const auto buildDir = settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build";
+		for( const auto &objPath : output.getObjectFilePaths() ) {
+			if( objPath.parent_path() == buildDir ) {
+				paths.push_back( objPath );
+			}
+		}
+		return paths;
+	}
+} // anonymous namespace
+
+bool CompilerBase::fetchFromCache( Build* build )
+{
+	try {
+		build->mCacheKey = generateCacheKey( *build );
+	}
+	catch( const CompilerException & ) {
+		return false;
+	}
+
+	auto &output = build->mOutput;
+	std::vector<ci::fs::path> fetchedPaths;
+	if( ! BuildCache( output.getBuildSettings().mCacheDirectory ).fetch( build->mCacheKey, getCacheFilePaths( output ), &fetchedPaths ) ) {
+		return false;
 	}
-	else {
-		throw CompilerException( "Failed Initializing Compiler Process at " + getCompilerPath().string() );
+	// nothing will be compiled, only the objects restored from the cache are left for CopyBuildOutput.
+	// Entries stored without their objects leave none, LinkAppObjs then falls back to the app's objects
+	auto &objPaths = output.getObjectFilePaths();
+	objPaths.erase( std::remove_if( objPaths.begin(), objPaths.end(), [&fetchedPaths]( const ci::fs::path &path ) {
+		return std::find( fetchedPaths.begin(), fetchedPaths.end(), path ) == fetchedPaths.end();
+	} ), objPaths.end() );
+	RT_BUILD_LOG( BuildLog::Category::Info, "1>  " << output.getOutputPath().filename() << " found in the build cache (" << build->mCacheKey << ")" );
+	return true;
+}
+	
+void CompilerBase::buildFinished( BuildId buildId )
+{
+	auto buildIt = mBuilds.find( buildId );
+	if( buildIt != mBuilds.end() ) {
+		
+		Build &build = buildIt->second;
+		if( ! build.mFailed && ! build.mCached && ! build.mPrebuild && ! finalizeOutput( &build.mOutput ) ) {
+			build.mFailed = true;
+		}
+		auto &dependencies = build.mOutput.getDependencies();
+		std::sort( dependencies.begin(), dependencies.end() );
+		dependencies.erase( std::unique( dependencies.begin(), dependencies.end() ), dependencies.end() );
+
+		for( const auto &warning : build.mOutput.getWarnings() ) {
+			BuildLog::instance().write( BuildLog::Category::Warning, "1>" + warning );
+		}	
+		if( ! build.mFailed ) {
+
+			// store the output before the post build steps move it around
+			if( ! build.mCached && ! build.mCacheKey.empty() && ! build.mOutput.getOutputPath().empty() ) {
+				const auto &output = build.mOutput;
+				BuildCache( output.getBuildSettings().mCacheDirectory ).store( build.mCacheKey, getCacheFilePaths( output ) );
+			}
+
+			// execute post build steps, a prebuild has no module for them to process
+			BuildOutput buildOutput = build.mOutput;
+			if( ! build.mPrebuild ) {
+				for( const auto &buildStep : buildOutput.getBuildSettings().mPostBuildSteps ) {
+					buildStep->execute( &buildOutput );
+				}
+			}
+
+			// print results
+			if( ! buildOutput.getFilePaths().empty() && ! buildOutput.getOutputPath().empty() ) {
+				RT_BUILD_LOG( BuildLog::Category::Info, "1>  " << buildOutput.getFilePaths().front().filename() << " -> " << buildOutput.getOutputPath() );
+				if( ! buildOutput.getPdbFilePath().empty() ) {
+					RT_BUILD_LOG( BuildLog::Category::Info, "1>  " << buildOutput.getFilePaths().front().filename() << " -> " << buildOutput.getPdbFilePath() );
+				}
+			}
+			if( buildOutput.getBuildSettings().isVerboseEnabled() ) {
+				for( const auto &timing : buildOutput.getJobTimings() ) {
+					RT_BUILD_LOG( BuildLog::Category::Info, "1>  " << timing.mName << ": " << std::chrono::duration_cast<std::chrono::milliseconds>( timing.mDuration ).count() << "ms" );
+				}
+			}
+			if( build.mCached ) {
+				BuildLog::instance().write( BuildLog::Category::Info, "========== Runtime Compiler Build: 0 succeeded, 0 failed, 1 up-to-date, 0 skipped ==========" );
+			}
+			else {
+				BuildLog::instance().write( BuildLog::Category::Info, "========== Runtime Compiler Build: 1 succeeded, 0 failed, 0 up-to-date, 0 skipped ==========" );
+			}
+			auto elapsed = std::chrono::system_clock::now() - buildOutput.getTimePoint();
+			auto elapsedMicro = std::chrono::duration_cast<std::chrono::microseconds>( elapsed ).count();
+			auto elapsedMinutes = std::chrono::duration_cast<std::chrono::hours>( elapsed ).count();
+			auto elapsedHours = std::chrono::duration_cast<std::chrono::hours>( elapsed ).count();
+			std::ostringstream oss;
+			oss << std::setfill('0') << std::setw(2) << elapsedHours << ":" << std::setw(2) << elapsedMinutes << ":"
+				<< std::setw(2) << ( elapsedMicro % 1000000000 ) / 1000000 << "." << std::setw(3) << ( elapsedMicro % 1000000 ) / 1000;
+			BuildLog::instance().write( BuildLog::Category::Info, "\nTime Elapsed " + oss.str() + "\n" );
+
+			// call the build finish callback
+			if( build.mCallback ) {
+				build.mCallback( buildOutput );
+			}
+		}
+		else {
+			for( const auto &error : build.mOutput.getErrors() ) {
+				BuildLog::instance().write( BuildLog::Category::Error, "1>" + error );
+			}
+			BuildLog::instance().write( BuildLog::Category::Error, "========== Runtime Compiler Build: 0 succeeded, 1 failed, 0 up-to-date, 0 skipped ==========" );
+		}
+
+		mBuilds.erase( buildIt );
 	}
 }
 
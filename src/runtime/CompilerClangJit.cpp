@@ -0,0 +1,189 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "runtime/CompilerClangJit.h"
+
+#if defined( CINDER_RT_EXPERIMENTAL_CLANG_JIT )
+
+#include "llvm/BinaryFormat/Magic.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+
+#include <sstream>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+CompilerClangJit::CompilerClangJit()
+	: mNumModules( 0 )
+{
+	llvm::InitializeNativeTarget();
+	llvm::InitializeNativeTargetAsmPrinter();
+
+	auto jit = llvm::orc::LLJITBuilder().create();
+	if( ! jit ) {
+		throw CompilerException( "Failed Initializing the JIT: " + llvm::toString( jit.takeError() ) );
+	}
+	mJit = std::shared_ptr<llvm::orc::LLJIT>( std::move( *jit ) );
+
+	// errors like unresolved symbols are reported to the session rather than returned, keep them for the build output
+	mJit->getExecutionSession().setErrorReporter( [this]( llvm::Error error ) {
+		mSessionErrors.push_back( llvm::toString( std::move( error ) ) );
+	} );
+}
+
+CompilerClangJit::~CompilerClangJit()
+{
+	// the modules still loaded release their code after the compiler is gone
+	mJit->getExecutionSession().setErrorReporter( []( llvm::Error error ) {
+		llvm::consumeError( std::move( error ) );
+	} );
+}
+
+CompilerClangJit& CompilerClangJit::instance()
+{
+	static CompilerClangJitPtr compiler = make_unique<CompilerClangJit>();
+	return *compiler.get();
+}
+
+std::string CompilerClangJit::printToString() const
+{
+	stringstream str;
+	
+	str << "Compiler driver: " << getDriver() << " (LLVM bitcode)" << endl;
+	str << "JIT target: " << mJit->getTargetTriple().str() << endl;
+	str << "Working directory: " << getWorkingDirectory() << endl;
+
+	return str.str();
+}
+
+std::string CompilerClangJit::getBuildDescription() const
+{
+	return CompilerClang::getBuildDescription() + ", JIT";
+}
+
+std::vector<std::string> CompilerClangJit::generateCompilerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const
+{
+	// same as a regular build except that the object files hold bitcode
+	auto args = CompilerClang::generateCompilerArgs( sourcePath, settings, output );
+	args.insert( args.begin() + 1, "-emit-llvm" );
+	return args;
+}
+
+std::vector<std::string> CompilerClangJit::generateLinkerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const
+{
+	// nothing to run, the objects are linked in memory by finalizeOutput
+	for( const auto &obj : settings.getObjPaths() ) {
+		output->getObjectFilePaths().push_back( obj );
+	}
+	return {};
+}
+
+bool CompilerClangJit::finalizeOutput( BuildOutput* output )
+{
+	// every build gets its own dylib so that the code of the previous version stays valid until the instances are swapped
+	mSessionErrors.clear();
+	auto dylib = mJit->createJITDylib( output->getBuildSettings().getModuleName() + "_" + to_string( ++mNumModules ) );
+	if( ! dylib ) {
+		output->getErrors().push_back( llvm::toString( dylib.takeError() ) );
+		return false;
+	}
+	llvm::orc::JITDylib &jitDylib = *dylib;
+
+	auto addError = [this, output, &jitDylib]( llvm::Error error ) {
+		output->getErrors().insert( output->getErrors().end(), mSessionErrors.begin(), mSessionErrors.end() );
+		output->getErrors().push_back( llvm::toString( std::move( error ) ) );
+		llvm::consumeError( mJit->getExecutionSession().removeJITDylib( jitDylib ) );
+		return false;
+	};
+
+	// the symbols the module doesn't define are looked up in the app, like a shared library would
+	auto generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess( mJit->getDataLayout().getGlobalPrefix() );
+	if( ! generator ) {
+		return addError( generator.takeError() );
+	}
+	jitDylib.addGenerator( std::move( *generator ) );
+
+	std::vector<std::string> definitions;
+	for( const auto &path : output->getObjectFilePaths() ) {
+		auto buffer = llvm::MemoryBuffer::getFile( path.string() );
+		if( ! buffer ) {
+			return addError( llvm::errorCodeToError( buffer.getError() ) );
+		}
+
+		if( llvm::identify_magic( (*buffer)->getBuffer() ) == llvm::file_magic::bitcode ) {
+			auto context = std::make_unique<llvm::LLVMContext>();
+			auto module = llvm::parseBitcodeFile( (*buffer)->getMemBufferRef(), *context );
+			if( ! module ) {
+				return addError( module.takeError() );
+			}
+			// remember a symbol per module to have them all compiled below
+			for( const auto &function : (*module)->functions() ) {
+				if( ! function.isDeclaration() && function.hasExternalLinkage() ) {
+					definitions.push_back( function.getName().str() );
+					break;
+				}
+			}
+			if( auto error = mJit->addIRModule( jitDylib, llvm::orc::ThreadSafeModule( std::move( *module ), std::move( context ) ) ) ) {
+				return addError( std::move( error ) );
+			}
+		}
+		else if( auto error = mJit->addObjectFile( jitDylib, std::move( *buffer ) ) ) {
+			return addError( std::move( error ) );
+		}
+	}
+
+	// modules are only compiled and linked when one of their symbols is looked up. Do it now so that unresolved symbols fail the build
+	for( const auto &definition : definitions ) {
+		if( auto symbol = mJit->lookup( jitDylib, definition ); ! symbol ) {
+			return addError( symbol.takeError() );
+		}
+	}
+	if( auto error = mJit->initialize( jitDylib ) ) {
+		return addError( std::move( error ) );
+	}
+
+	// the dylib is removed with the last copy of the lookup, once the module has moved on to the next version
+	std::shared_ptr<llvm::orc::JITDylib> dylibOwner( &jitDylib, [jit = mJit]( llvm::orc::JITDylib* jitDylib ) {
+		llvm::consumeError( jit->getExecutionSession().removeJITDylib( *jitDylib ) );
+	} );
+	output->setSymbolLookup( [jit = mJit, dylibOwner]( const std::string &symbol ) -> void* {
+		auto address = jit->lookup( *dylibOwner, symbol );
+		if( ! address ) {
+			llvm::consumeError( address.takeError() );
+			return nullptr;
+		}
+		return reinterpret_cast<void*>( static_cast<uintptr_t>( address->getAddress() ) );
+	} );
+	return true;
+}
+
+} // namespace runtime
+
+#endif
@@ -0,0 +1,343 @@
+#include "runtime/CompilerGcc.h"
+#include "runtime/Module.h"
+
+#include "cinder/app/App.h"
+#include "cinder/Log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+CompilerGcc::CompilerGcc()
+{
+	if( mVerbose ) {
+		CI_LOG_I( "Compiler Settings: \n" << printToString() );
+	}
+
+	initializeJobs();
+}
+
+CompilerGcc::~CompilerGcc()
+{
+}
+
+CompilerGcc& CompilerGcc::instance()
+{
+	static CompilerGccPtr compiler = make_unique<CompilerGcc>();
+	return *compiler.get();
+}
+
+CompilerClang& CompilerClang::instance()
+{
+	static CompilerClangPtr compiler = make_unique<CompilerClang>();
+	return *compiler.get();
+}
+
+std::string CompilerGcc::getDriver() const
+{
+	return "g++";
+}
+
+std::string CompilerClang::getDriver() const
+{
+	return "clang++";
+}
+
+std::string CompilerGcc::printToString() const
+{
+	stringstream str;
+	
+	str << "Compiler driver: " << getDriver() << endl;
+	str << "Working directory: " << getWorkingDirectory() << endl;
+
+	return str.str();
+}
+
+std::string CompilerGcc::getBuildDescription() const
+{
+#if defined( NDEBUG )
+	return "Compiler: " + getDriver() + ", Configuration: Release";
+#else
+	return "Compiler: " + getDriver() + ", Configuration: Debug";
+#endif
+}
+
+ci::fs::path CompilerGcc::getWorkingDirectory() const
+{
+	return fs::current_path();
+}
+
+namespace {
+	//! Returns the path of the object file generated for sourcePath
+	fs::path getObjectFilePath( const fs::path &sourcePath, const BuildSettings &settings )
+	{
+		if( settings.getObjectFilePath().empty() ) {
+			return settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( sourcePath.stem().string() + ".o" );
+		}
+		else if( settings.getObjectFilePath().has_extension() ) {
+			return settings.getObjectFilePath();
+		}
+		return settings.getObjectFilePath() / ( sourcePath.stem().string() + ".o" );
+	}
+
+	//! Translates a library name to the driver syntax. Full paths and flags are left untouched, "name.lib" and "name" become "-lname"
+	std::string getLibraryArg( const std::string &library )
+	{
+		fs::path path( library );
+		if( library.compare( 0, 1, "-" ) == 0 || path.has_parent_path() || path.extension() == ".a" || path.extension() == ".so" || path.extension() == ".o" ) {
+			return library;
+		}
+		return "-l" + ( path.extension() == ".lib" ? path.stem().string() : library );
+	}
+
+	//! Returns the gcc and clang options closest to the code generation settings, which follow msvc
+	std::vector<std::string> generateCodeGenerationArgs( const BuildSettings &settings )
+	{
+		std::vector<std::string> args;
+		auto optimization = settings.getOptimization();
+		switch( optimization ) {
+			case BuildSettings::Optimization::Disabled: args.push_back( "-O0" ); break;
+			case BuildSettings::Optimization::MinSpace: args.push_back( "-Os" ); break;
+			case BuildSettings::Optimization::MaxSpeed: args.push_back( "-O2" ); break;
+			case BuildSettings::Optimization::Full: args.push_back( "-O3" ); break;
+			default: break;
+		}
+		// the builtins are always expanded when optimizing, IntrinsicFunctions has no equivalent
+		switch( settings.getInlineFunctionExpansion() ) {
+			case BuildSettings::InlineFunctionExpansion::Disabled: args.push_back( "-fno-inline" ); break;
+			case BuildSettings::InlineFunctionExpansion::OnlyExplicitInline: args.push_back( "-fno-inline-functions" ); break;
+			case BuildSettings::InlineFunctionExpansion::AnySuitable: args.push_back( "-finline-functions" ); break;
+			default: break;
+		}
+#if defined( __x86_64__ ) || defined( __i386__ )
+		switch( settings.getEnhancedInstructionSet() ) {
+			case BuildSettings::InstructionSet::SSE: args.push_back( "-msse" ); break;
+			case BuildSettings::InstructionSet::SSE2: args.push_back( "-msse2" ); break;
+			case BuildSettings::InstructionSet::AVX: args.push_back( "-mavx" ); break;
+			// /arch:AVX2 lets msvc contract to fma instructions
+			case BuildSettings::InstructionSet::AVX2: args.insert( args.end(), { "-mavx2", "-mfma" } ); break;
+			case BuildSettings::InstructionSet::AVX512: args.insert( args.end(), { "-mavx512f", "-mavx512cd", "-mavx512bw", "-mavx512dq", "-mavx512vl", "-mfma" } ); break;
+			default: break;
+		}
+#endif
+		switch( settings.getFloatingPointModel() ) {
+			// msvc doesn't contract floating point operations unless fast
+			case BuildSettings::FloatingPointModel::Precise: args.push_back( "-ffp-contract=off" ); break;
+			case BuildSettings::FloatingPointModel::Strict: args.insert( args.end(), { "-ffp-contract=off", "-frounding-math" } ); break;
+			case BuildSettings::FloatingPointModel::Fast: args.push_back( "-ffast-math" ); break;
+			default: break;
+		}
+		// -Os would enable the optimizations of an unoptimized build, and speed is what the other levels favor already
+		if( settings.getFavorSizeOrSpeed() == BuildSettings::FavorSizeOrSpeed::Size && optimization != BuildSettings::Optimization::Default && optimization != BuildSettings::Optimization::Disabled ) {
+			args.push_back( "-Os" );
+		}
+		return args;
+	}
+} // anonymous namespace
+
+std::vector<std::string> CompilerGcc::generateCommonArgs( const BuildSettings &settings ) const
+{
+	std::vector<std::string> args = { "-fPIC" };
+#if ! defined( NDEBUG )
+	args.push_back( "-g" );
+#endif
+
+	for( const auto &define : settings.mPpDefinitions ) {
+		args.push_back( "-D" + define );
+	}
+	for( const auto &include : settings.mIncludes ) {
+		args.push_back( "-I" + include.generic_string() );
+	}
+	// before the compiler options, which can override them
+	auto codeGenerationArgs = generateCodeGenerationArgs( settings );
+	args.insert( args.end(), codeGenerationArgs.begin(), codeGenerationArgs.end() );
+	args.insert( args.end(), settings.mCompilerOptions.begin(), settings.mCompilerOptions.end() );
+
+	return args;
+}
+
+std::vector<std::string> CompilerGcc::generatePrecompiledHeaderArgs( const BuildSettings &settings, BuildOutput* output ) const
+{
+	// the .gch is written next to the header, where the driver looks for it when the header is included
+	auto header = settings.getIntermediatePath() / "runtime" / settings.getModuleName() / ( settings.getModuleName() + "Pch.h" );
+	std::vector<std::string> args = { getDriver(), "-x", "c++-header" };
+	
+	auto commonArgs = generateCommonArgs( settings );
+	args.insert( args.end(), commonArgs.begin(), commonArgs.end() );
+
+	args.push_back( header.generic_string() );
+	args.push_back( "-o" );
+	args.push_back( header.generic_string() + ".gch" );
+	args.push_back( "-MMD" );
+	args.push_back( "-MF" );
+	args.push_back( header.generic_string() + ".gch.d" );
+
+	return args;
+}
+
+std::vector<std::string> CompilerGcc::generateCompilerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const
+{
+	std::vector<std::string> args = { getDriver(), "-c" };
+
+	auto commonArgs = generateCommonArgs( settings );
+	args.insert( args.end(), commonArgs.begin(), commonArgs.end() );
+
+	// make the precompiled header directory searched first so that forced includes pick the .gch
+	if( settings.mUsePch ) {
+		args.push_back( "-I" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() ).generic_string() );
+	}
+	for( const auto &include : settings.mForcedIncludes ) {
+		args.push_back( "-include" );
+		args.push_back( include );
+	}
+
+	auto objectPath = getObjectFilePath( sourcePath, settings );
+	args.push_back( sourcePath.generic_string() );
+	args.push_back( "-o" );
+	args.push_back( objectPath.generic_string() );
+	// the headers included, system headers aside, are written next to the object file
+	args.push_back( "-MMD" );
+	args.push_back( "-MF" );
+	args.push_back( objectPath.generic_string() + ".d" );
+	output->getObjectFilePaths().push_back( objectPath );
+
+	return args;
+}
+
+std::vector<std::string> CompilerGcc::generatePreprocessorArgs( const ci::fs::path &sourcePath, const BuildSettings &settings ) const
+{
+	std::vector<std::string> args = { getDriver(), "-E", "-P" };
+
+	auto commonArgs = generateCommonArgs( settings );
+	args.insert( args.end(), commonArgs.begin(), commonArgs.end() );
+
+	// the driver doesn't use the .gch when preprocessing, the forced precompiled header is read as a regular header
+	args.push_back( "-I" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() ).generic_string() );
+	for( const auto &include : settings.mForcedIncludes ) {
+		args.push_back( "-include" );
+		args.push_back( include );
+	}
+	args.push_back( sourcePath.generic_string() );
+
+	return args;
+}
+
+std::vector<std::string> CompilerClang::generatePrecompiledHeaderArgs( const BuildSettings &settings, BuildOutput* output ) const
+{
+	auto args = CompilerGcc::generatePrecompiledHeaderArgs( settings, output );
+	if( settings.isCompilerProfilingEnabled() ) {
+		args.insert( args.begin() + 1, "-ftime-trace" );
+	}
+	return args;
+}
+
+std::vector<std::string> CompilerClang::generateCompilerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const
+{
+	auto args = CompilerGcc::generateCompilerArgs( sourcePath, settings, output );
+	if( settings.isCompilerProfilingEnabled() ) {
+		args.insert( args.begin() + 1, "-ftime-trace" );
+	}
+	return args;
+}
+
+void CompilerClang::readProfile( const Job &job, CompilerProfile* profile ) const
+{
+	// the trace is named after the output, "Source.o" gives "Source.json"
+	const auto &args = job.getArguments();
+	auto outputArg = std::find( args.begin(), args.end(), "-o" );
+	if( outputArg != args.end() && ++outputArg != args.end() ) {
+		profile->readTimeTrace( fs::path( *outputArg ).replace_extension( ".json" ) );
+	}
+}
+
+std::vector<ci::fs::path> CompilerGcc::readDependencies( const Job &job ) const
+{
+	// the dependencies are written as a make rule to the file following -MF
+	const auto &args = job.getArguments();
+	auto fileArg = std::find( args.begin(), args.end(), "-MF" );
+	if( fileArg == args.end() || ++fileArg == args.end() ) {
+		return {};
+	}
+	ifstream file( *fileArg, ios::binary );
+	const string rule( ( istreambuf_iterator<char>( file ) ), istreambuf_iterator<char>() );
+	size_t start = rule.find( ": " );
+	if( start == string::npos ) {
+		return {};
+	}
+
+	// "Source.o: Source.cpp Header.h \<newline> Other\ Header.h", the first prerequisite is the source itself
+	std::vector<ci::fs::path> dependencies;
+	std::string path;
+	bool source = true;
+	auto addPath = [&]() {
+		if( ! path.empty() && ! source ) {
+			// the paths are relative to the working directory or to the including file, and shared by many types
+			fs::path dependency = fs::path( path ).is_absolute() ? fs::path( path ) : getWorkingDirectory() / path;
+			std::error_code error;
+			fs::path canonical = fs::canonical( dependency, error );
+			dependencies.push_back( error ? dependency : canonical );
+		}
+		source = source && path.empty();
+		path.clear();
+	};
+	for( size_t i = start + 2; i < rule.size(); ++i ) {
+		const char c = rule[i];
+		if( c == '\\' && i + 1 < rule.size() && ( rule[i + 1] == ' ' || rule[i + 1] == '#' ) ) {
+			path += rule[++i];
+		}
+		else if( c == '$' && i + 1 < rule.size() && rule[i + 1] == '$' ) {
+			path += rule[++i];
+		}
+		else if( c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\\' ) {
+			addPath();
+		}
+		else {
+			path += c;
+		}
+	}
+	addPath();
+
+	return dependencies;
+}
+
+std::vector<std::string> CompilerGcc::generateLinkerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const
+{
+	auto outputPath = settings.mOutputPath.empty() ? ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + Module::getExtension() ) ) : settings.mOutputPath;
+	output->setOutputPath( outputPath );
+	std::vector<std::string> args = { getDriver(), "-shared", "-fPIC", "-o", outputPath.generic_string() };
+#if ! defined( CINDER_MAC )
+	// bind the module's references to its own functions and vtables. An app linked with -rdynamic exports the
+	// previous version of the type, which would otherwise take precedence and keep running the old code
+	args.push_back( "-Wl,-Bsymbolic" );
+#endif
+
+	// objs produced by the compiler jobs
+	for( const auto &obj : output->getObjectFilePaths() ) {
+		args.push_back( obj.generic_string() );
+	}
+
+	// additional objs to link
+	for( const auto &obj : settings.mObjPaths ) {
+		args.push_back( obj.generic_string() );
+		output->getObjectFilePaths().push_back( obj );
+	}
+
+	// libraries come after the objects as they are only searched for symbols already referenced.
+	// There's no module definition on this platform, symbols are exported by default
+	for( const auto &libraryPath : settings.mLibraryPaths ) {
+		args.push_back( "-L" + libraryPath.generic_string() );
+	}
+	for( const auto &library : settings.mLibraries ) {
+		args.push_back( getLibraryArg( library ) );
+	}
+	args.insert( args.end(), settings.mLinkerOptions.begin(), settings.mLinkerOptions.end() );
+
+	return args;
+}
+
+}
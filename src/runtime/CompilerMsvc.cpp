@@ -0,0 +1,487 @@
+#include "runtime/CompilerMsvc.h"
+#include "runtime/Hash.h"
+#include "runtime/Module.h"
+#include "runtime/Process.h"
+#include "runtime/ProjectConfiguration.h"
+
+#include "cinder/app/App.h"
+#include "cinder/Xml.h"
+#include "cinder/Log.h"
+#include "cinder/Utilities.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+// Examples: turns 'MyClass' into '??_7MyClass@@6B@', or 'a::b::MyClass' into '??_7MyClass@b@a@@6B@'
+// See docs in generateLinkerCommand()
+// See MS Doc "Decorated Names": https://msdn.microsoft.com/en-us/library/56h2zst2.aspx?f=255&MSPPError=-2147217396#Format
+std::string	CompilerMsvc::getSymbolForVTable( const std::string &typeName ) const
+{
+	auto parts = ci::split( typeName, "::" );
+	string decoratedName;
+	for( auto rIt = parts.rbegin(); rIt != parts.rend(); ++rIt ) {
+		if( ! rIt->empty() ) // handle leading "::" case, which results in any empty part
+			decoratedName += *rIt + "@";
+	}
+
+	return "??_7" + decoratedName + "@6B@";
+}
+
+std::string CompilerMsvc::printToString() const
+{
+	stringstream str;
+	
+	str << "Compiler environment: " << getVcvarsallPath() << " " << getVcvarsallArgs() << endl;
+	str << "Working directory: " << getWorkingDirectory() << endl;
+
+	return str.str();
+}
+
+void CompilerMsvc::debugLog( BuildSettings *settings ) const
+{
+	CI_LOG_I( "Compiler Settings: " << printToString() );
+	CI_LOG_I( "ProjectConfiguration: " << ProjectConfiguration::instance().printToString() );
+
+	if( settings ) {
+		CI_LOG_I( "BuildSettings: " << settings->printToString() );
+	}
+}
+
+CompilerMsvc::CompilerMsvc()
+{
+	if( mVerbose ) {
+		CI_LOG_I( "Compiler Settings: \n" << printToString() );
+	}
+
+	initializeJobs();
+}
+
+CompilerMsvc::~CompilerMsvc()
+{
+}
+
+CompilerMsvc& CompilerMsvc::instance()
+{
+	static CompilerMsvcPtr compiler = make_unique<CompilerMsvc>();
+	return *compiler.get();
+}
+
+std::vector<std::string> CompilerMsvc::captureEnvironment() const
+{
+	if( ! fs::exists( getVcvarsallPath() ) ) {
+		throw CompilerException( "Failed Initializing Compiler Environment at " + getVcvarsallPath().string() );
+	}
+
+	// run vcvarsall once and dump the environment it sets up, which is then inherited by every job
+	Process process( "cmd /s /c \"\"" + getVcvarsallPath().string() + "\"" + getVcvarsallArgs() + " >nul && set\"", Process::Options().path( getWorkingDirectory().string() ).redirectInput( false ).redirectError( false ) );
+	auto output = process.getOutputSync();
+	if( process.terminate() != 0 ) {
+		throw CompilerException( "Failed Initializing Compiler Environment at " + getVcvarsallPath().string() );
+	}
+
+	std::vector<std::string> environment;
+	for( const auto &variable : ci::split( output, "\r\n" ) ) {
+		if( variable.find( '=' ) != string::npos ) {
+			environment.push_back( variable );
+		}
+	}
+	return environment;
+}
+
+std::string CompilerMsvc::getBuildDescription() const
+{
+	return "Project: " + ProjectConfiguration::instance().getProjectPath().stem().string() + ", Configuration: " + ProjectConfiguration::instance().getConfiguration() + " " + ProjectConfiguration::instance().getPlatform();
+}
+
+ci::fs::path CompilerMsvc::getWorkingDirectory() const
+{
+	return ProjectConfiguration::instance().getProjectDir();
+}
+
+ci::fs::path CompilerMsvc::getVcvarsallPath() const
+{
+#if _MSC_VER == 1900
+	return "C:\\Program Files (x86)\\Microsoft Visual Studio 14.0\\VC\\vcvarsall.bat";
+#elif _MSC_VER >= 1910
+	return "C:\\Program Files (x86)\\Microsoft Visual Studio\\2017\\Community\\VC\\Auxiliary\\Build\\vcvarsall.bat";
+#else
+	#error Visual Studio version not supported.
+#endif
+}
+
+std::string CompilerMsvc::getVcvarsallArgs() const
+{
+#ifdef _WIN64
+	return " amd64";
+#else
+	return " x86";
+#endif
+}
+
+namespace {
+	//! Adds every string of values to hash, each one terminated so that { "ab" } and { "a", "b" } differ
+	void hashStrings( Hash* hash, const std::vector<std::string> &values )
+	{
+		hash->update( static_cast<uint64_t>( values.size() ) );
+		for( const auto &value : values ) {
+			hash->update( value ).update( "\0", 1 );
+		}
+	}
+	void hashStrings( Hash* hash, const std::vector<fs::path> &values )
+	{
+		hash->update( static_cast<uint64_t>( values.size() ) );
+		for( const auto &value : values ) {
+			hash->update( value.generic_string() ).update( "\0", 1 );
+		}
+	}
+
+	//! Returns the cl options of the code generation settings
+	std::vector<std::string> generateCodeGenerationArgs( const BuildSettings &settings )
+	{
+		std::vector<std::string> args;
+		switch( settings.getOptimization() ) {
+			case BuildSettings::Optimization::Disabled: args.push_back( "/Od" ); break;
+			case BuildSettings::Optimization::MinSpace: args.push_back( "/O1" ); break;
+			case BuildSettings::Optimization::MaxSpeed: args.push_back( "/O2" ); break;
+			case BuildSettings::Optimization::Full: args.push_back( "/Ox" ); break;
+			default: break;
+		}
+		// the run-time error checks can't be combined with the optimizations
+		if( settings.getOptimization() == BuildSettings::Optimization::Default || settings.getOptimization() == BuildSettings::Optimization::Disabled ) {
+			args.push_back( "/RTC1" );
+		}
+		if( settings.isIntrinsicFunctionsEnabled() ) {
+			args.push_back( "/Oi" );
+		}
+		switch( settings.getInlineFunctionExpansion() ) {
+			case BuildSettings::InlineFunctionExpansion::Disabled: args.push_back( "/Ob0" ); break;
+			case BuildSettings::InlineFunctionExpansion::OnlyExplicitInline: args.push_back( "/Ob1" ); break;
+			case BuildSettings::InlineFunctionExpansion::AnySuitable: args.push_back( "/Ob2" ); break;
+			default: break;
+		}
+		switch( settings.getEnhancedInstructionSet() ) {
+			case BuildSettings::InstructionSet::NoExtensions: args.push_back( "/arch:IA32" ); break;
+			case BuildSettings::InstructionSet::SSE: args.push_back( "/arch:SSE" ); break;
+			case BuildSettings::InstructionSet::SSE2: args.push_back( "/arch:SSE2" ); break;
+			case BuildSettings::InstructionSet::AVX: args.push_back( "/arch:AVX" ); break;
+			case BuildSettings::InstructionSet::AVX2: args.push_back( "/arch:AVX2" ); break;
+			case BuildSettings::InstructionSet::AVX512: args.push_back( "/arch:AVX512" ); break;
+			default: break;
+		}
+		switch( settings.getFloatingPointModel() ) {
+			case BuildSettings::FloatingPointModel::Precise: args.push_back( "/fp:precise" ); break;
+			case BuildSettings::FloatingPointModel::Strict: args.push_back( "/fp:strict" ); break;
+			case BuildSettings::FloatingPointModel::Fast: args.push_back( "/fp:fast" ); break;
+			default: break;
+		}
+		switch( settings.getFavorSizeOrSpeed() ) {
+			case BuildSettings::FavorSizeOrSpeed::Size: args.push_back( "/Os" ); break;
+			case BuildSettings::FavorSizeOrSpeed::Speed: args.push_back( "/Ot" ); break;
+			default: break;
+		}
+		return args;
+	}
+} // anonymous namespace
+
+std::string CompilerMsvc::getCompilerResponseFile( const BuildSettings &settings ) const
+{
+	auto codeGenerationArgs = generateCodeGenerationArgs( settings );
+
+	Hash fingerprint;
+	fingerprint.update( "compiler" );
+	hashStrings( &fingerprint, settings.mPpDefinitions );
+	hashStrings( &fingerprint, settings.mIncludes );
+	hashStrings( &fingerprint, settings.mForcedIncludes );
+	hashStrings( &fingerprint, codeGenerationArgs );
+	hashStrings( &fingerprint, settings.mCompilerOptions );
+
+	return getResponseFile( "Compiler", fingerprint.getValue(), settings, [&settings, &codeGenerationArgs]() {
+		std::vector<std::string> args;
+		for( const auto &define : settings.mPpDefinitions ) {
+			args.push_back( "/D" + define );
+		}
+		for( const auto &include : settings.mIncludes ) {
+			args.push_back( "/I" + include.generic_string() );
+		}
+		for( const auto &include : settings.mForcedIncludes ) {
+			args.push_back( "/FI" + include );
+		}
+		// before the compiler options, which can override them
+		args.insert( args.end(), codeGenerationArgs.begin(), codeGenerationArgs.end() );
+		args.insert( args.end(), settings.mCompilerOptions.begin(), settings.mCompilerOptions.end() );
+		return args;
+	} );
+}
+
+std::string CompilerMsvc::getLinkerResponseFile( const BuildSettings &settings ) const
+{
+	Hash fingerprint;
+	fingerprint.update( "linker" );
+	hashStrings( &fingerprint, settings.mLibraryPaths );
+	hashStrings( &fingerprint, settings.mLibraries );
+	hashStrings( &fingerprint, settings.mLinkerOptions );
+
+	return getResponseFile( "Linker", fingerprint.getValue(), settings, [&settings]() {
+		std::vector<std::string> args;
+		for( const auto &libraryPath : settings.mLibraryPaths ) {
+			args.push_back( "/LIBPATH:" + libraryPath.generic_string() );
+		}
+		args.insert( args.end(), settings.mLibraries.begin(), settings.mLibraries.end() );
+		args.insert( args.end(), settings.mLinkerOptions.begin(), settings.mLinkerOptions.end() );
+		return args;
+	} );
+}
+
+std::string CompilerMsvc::getResponseFile( const std::string &name, uint64_t fingerprint, const BuildSettings &settings, const std::function<std::vector<std::string>()> &generateArgs ) const
+{
+	// the files are named after their content and shared by the modules and builds with the same settings
+	Hash key;
+	key.update( fingerprint ).update( settings.getIntermediatePath().generic_string() );
+	std::lock_guard<std::mutex> lock( mResponseFilesMutex );
+	auto responseFile = mResponseFiles.find( key.getValue() );
+	if( responseFile != mResponseFiles.end() && fs::exists( responseFile->second.substr( 1 ) ) ) {
+		return responseFile->second;
+	}
+
+	auto path = settings.getIntermediatePath() / "runtime" / ( name + "_" + key.toString() + ".rsp" );
+	if( ! fs::exists( path ) ) {
+		// the file is reused as long as it exists, write a temporary file and rename it so that it's never partial
+		std::error_code error;
+		fs::create_directories( path.parent_path(), error );
+		// other apps of the project and builds with the same settings can write the same file, each needs its own temporary file
+		static std::atomic<uint64_t> sCounter( 0 );
+		auto unique = std::hash<std::thread::id>()( std::this_thread::get_id() ) ^ std::chrono::steady_clock::now().time_since_epoch().count();
+		auto tempPath = fs::path( path.string() + ".tmp" + std::to_string( unique ) + "_" + std::to_string( sCounter++ ) );
+		{
+			ofstream file( tempPath, ios::binary | ios::trunc );
+			for( const auto &arg : generateArgs() ) {
+				file << Process::quoteArgument( arg ) << "\r\n";
+			}
+			file.close();
+			error = file ? std::error_code() : std::make_error_code( std::errc::io_error );
+		}
+		if( ! error ) {
+			fs::rename( tempPath, path, error );
+			// another writer got there first, its file has the same content
+			if( error && fs::exists( path ) ) {
+				fs::remove( tempPath, error );
+				error.clear();
+			}
+		}
+		// the build fails on the missing file and the next one tries again
+		if( error ) {
+			CI_LOG_E( "Failed writing " << path << ": " << error.message() );
+			fs::remove( tempPath, error );
+			return "@" + path.string();
+		}
+	}
+
+	return mResponseFiles[key.getValue()] = "@" + path.string();
+}
+
+std::vector<std::string> CompilerMsvc::generatePrecompiledHeaderArgs( const BuildSettings &settings, BuildOutput* output ) const
+{
+	auto buildDir = settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build";
+	std::vector<std::string> args = { "cl.exe", "/c" };
+	
+	args.push_back( getCompilerResponseFile( settings ) );
+		
+	args.push_back( settings.mObjectFilePath.empty() ? "/Fo" + ( buildDir / "/" ).string() : "/Fo" + settings.mObjectFilePath.generic_string() );
+	args.push_back( "/Fp" + ( buildDir / ( settings.getModuleName() + ".pch" ) ).string() );
+#if defined( _DEBUG )
+	args.push_back( "/Fd" + ( buildDir / ( settings.getModuleName() + ".pdb" ) ).string() );
+#endif
+
+	args.push_back( "/Yc" + settings.getModuleName() + "Pch.h" );
+	args.push_back( "/showIncludes" );
+	if( settings.mCompilerProfiling ) {
+		args.push_back( "/Bt+" );
+		args.push_back( "/d1reportTime" );
+	}
+	args.push_back( ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / ( settings.getModuleName() + "Pch.cpp" ) ).generic_string() );
+
+	return args;
+}
+
+namespace {
+	//! Returns the path of the object file cl generates for sourcePath
+	fs::path getObjectFilePath( const fs::path &sourcePath, const BuildSettings &settings )
+	{
+		if( settings.getObjectFilePath().empty() ) {
+			return settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( sourcePath.stem().string() + ".obj" );
+		}
+		else if( settings.getObjectFilePath().has_extension() ) {
+			return settings.getObjectFilePath();
+		}
+		return settings.getObjectFilePath() / ( sourcePath.stem().string() + ".obj" );
+	}
+} // anonymous namespace
+
+std::vector<std::string> CompilerMsvc::generateCompilerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const
+{
+	auto buildDir = settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build";
+	auto objectPath = getObjectFilePath( sourcePath, settings );
+	std::vector<std::string> args = { "cl.exe", "/c" };
+	
+	args.push_back( getCompilerResponseFile( settings ) );
+
+	args.push_back( "/Fo" + objectPath.string() );
+#if defined( _DEBUG )
+	args.push_back( settings.mPdbPath.empty() ? "/Fd" + ( buildDir / ( settings.getModuleName() + ".pdb" ) ).string() : "/Fd" + settings.mPdbPath.generic_string() );
+	// the translation units are compiled by concurrent cl processes sharing the same pdb
+	args.push_back( "/FS" );
+#endif
+	
+	if( settings.mUsePch ) {
+		args.push_back( "/Fp" + ( buildDir / ( settings.getModuleName() + ".pch" ) ).string() );
+		args.push_back( "/Yu" + settings.getModuleName() + "Pch.h" );
+	}
+	// lists the headers included in the output, see parseJobOutput
+	args.push_back( "/showIncludes" );
+	// reports the time spent on each pass, header and definition, see parseProfile
+	if( settings.mCompilerProfiling ) {
+		args.push_back( "/Bt+" );
+		args.push_back( "/d1reportTime" );
+	}
+
+	args.push_back( sourcePath.generic_string() );
+	output->getObjectFilePaths().push_back( objectPath );
+
+	return args;
+}
+
+std::vector<std::string> CompilerMsvc::generatePreprocessorArgs( const ci::fs::path &sourcePath, const BuildSettings &settings ) const
+{
+	std::vector<std::string> args = { "cl.exe", "/EP" };
+	
+	args.push_back( getCompilerResponseFile( settings ) );
+	// the forced precompiled header is read as a regular header, the include directories being searched in order regardless of the forced includes position
+	args.push_back( "/I" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() ).generic_string() );
+	args.push_back( sourcePath.generic_string() );
+
+	return args;
+}
+
+namespace {
+	//! Returns path lower-cased with backslash separators, as paths are compared case-insensitively on windows
+	std::string normalizePath( std::string_view path )
+	{
+		std::string normalized( path );
+		std::transform( normalized.begin(), normalized.end(), normalized.begin(), []( char c ) { return c == '/' ? '\\' : static_cast<char>( tolower( static_cast<unsigned char>( c ) ) ); } );
+		return normalized;
+	}
+} // anonymous namespace
+
+bool CompilerMsvc::isSystemHeader( std::string_view path ) const
+{
+	// the system headers are the ones found through the INCLUDE variable set by vcvarsall
+	if( ! mSystemIncludeDirs ) {
+		mSystemIncludeDirs = make_unique<std::vector<std::string>>();
+		for( const auto &variable : getEnvironment() ) {
+			if( variable.size() > 8 && normalizePath( variable.substr( 0, 8 ) ) == "include=" ) {
+				for( const auto &directory : ci::split( variable.substr( 8 ), ';' ) ) {
+					if( ! directory.empty() ) {
+						mSystemIncludeDirs->push_back( normalizePath( directory ) );
+						if( mSystemIncludeDirs->back().back() != '\\' ) {
+							mSystemIncludeDirs->back() += '\\';
+						}
+					}
+				}
+			}
+		}
+	}
+
+	const std::string normalized = normalizePath( path );
+	for( const auto &directory : *mSystemIncludeDirs ) {
+		if( normalized.compare( 0, directory.size(), directory ) == 0 ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CompilerMsvc::parseDependency( std::string_view line, ci::fs::path* header ) const
+{
+	// "Note: including file:" lines written by /showIncludes, indented by the include depth
+	static const std::string_view sIncludeNote = "Note: including file:";
+	if( line.compare( 0, sIncludeNote.size(), sIncludeNote ) != 0 ) {
+		return false;
+	}
+	auto path = line.substr( std::min( line.find_first_not_of( ' ', sIncludeNote.size() ), line.size() ) );
+	while( ! path.empty() && ( path.back() == '\r' || path.back() == ' ' ) ) {
+		path.remove_suffix( 1 );
+	}
+	if( ! path.empty() && ! isSystemHeader( path ) ) {
+		*header = fs::path( std::string( path ) );
+	}
+	return true;
+}
+
+bool CompilerMsvc::parseProfile( std::string_view line, CompilerProfile* profile ) const
+{
+	return profile->parseReportTimeLine( line );
+}
+
+std::vector<std::string> CompilerMsvc::generateLinkerArgs( const ci::fs::path &sourcePath, const BuildSettings &settings, BuildOutput* output ) const
+{
+	auto buildDir = settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build";
+	std::vector<std::string> args = { "link.exe" };
+	
+	args.push_back( getLinkerResponseFile( settings ) );
+	
+	if( ! settings.mModuleDefPath.empty() ) {
+		args.push_back( "/DEF:" + settings.mModuleDefPath.string() );
+	}
+	
+	auto outputPath = settings.mOutputPath.empty() ? ( buildDir / ( settings.getModuleName() + Module::getExtension() ) ) : settings.mOutputPath;
+	output->setOutputPath( outputPath );
+	args.push_back( "/OUT:" + outputPath.string() );
+#if defined( _DEBUG )
+	output->setPdbFilePath( settings.mPdbPath.empty() ? ( buildDir / ( settings.getModuleName() + ".pdb" ) ) : settings.mPdbPath );
+	// TODO: Use project settings
+	args.push_back( "/DEBUG" );
+	//args.push_back( "/DEBUG:FASTLINK" );
+	args.push_back( settings.mPdbPath.empty() ? "/PDB:" + ( buildDir / ( settings.getModuleName() + ".pdb" ) ).string() : "/PDB:" + settings.mPdbPath.generic_string() );
+	args.push_back( settings.mPdbAltPath.empty() ? "/PDBALTPATH:" + ( buildDir / ( settings.getModuleName() + ".pdb" ) ).string() : "/PDBALTPATH:" + settings.mPdbAltPath.generic_string() );
+#endif
+	args.push_back( "/INCREMENTAL" );
+	args.push_back( "/DLL" );
+	
+	// objs produced by the compiler job
+	for( const auto &obj : output->getObjectFilePaths() ) {
+		args.push_back( obj.generic_string() );
+	}
+
+	// additional objs to link
+	for( const auto &obj : settings.mObjPaths ) {
+		args.push_back( obj.generic_string() );
+		output->getObjectFilePaths().push_back( obj );
+	}
+
+	return args;
+}
+
+
+namespace {
+std::string trimProjectDir( const std::string &s )
+{
+	auto it = s.find( ProjectConfiguration::instance().getProjectDir().generic_string() );
+	if( it != std::string::npos ) {
+		return s.substr( ProjectConfiguration::instance().getProjectDir().generic_string().length() );
+	}
+	else {
+		return s;
+	}
+}
+}
+
+}
\ No newline at end of file
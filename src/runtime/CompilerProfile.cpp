@@ -0,0 +1,256 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "runtime/CompilerProfile.h"
+#include "runtime/JsonReader.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+CompilerProfile::CompilerProfile()
+{
+}
+
+std::map<std::string,CompilerProfile::Entry>& CompilerProfile::getCategory( Category category )
+{
+	return category == Category::Phase ? mPhases : category == Category::Header ? mHeaders : mInstantiations;
+}
+
+const std::map<std::string,CompilerProfile::Entry>& CompilerProfile::getCategory( Category category ) const
+{
+	return category == Category::Phase ? mPhases : category == Category::Header ? mHeaders : mInstantiations;
+}
+
+void CompilerProfile::add( Category category, const std::string &name, std::chrono::microseconds duration )
+{
+	auto &entry = getCategory( category )[name];
+	if( entry.mName.empty() ) {
+		entry = { name, std::chrono::microseconds( 0 ), 0 };
+	}
+	entry.mDuration += duration;
+	entry.mCount++;
+}
+
+void CompilerProfile::merge( const CompilerProfile &other )
+{
+	for( auto category : { Category::Phase, Category::Header, Category::Instantiation } ) {
+		auto &entries = getCategory( category );
+		for( const auto &otherEntry : other.getCategory( category ) ) {
+			auto &entry = entries[otherEntry.first];
+			if( entry.mName.empty() ) {
+				entry = otherEntry.second;
+			}
+			else {
+				entry.mDuration += otherEntry.second.mDuration;
+				entry.mCount += otherEntry.second.mCount;
+			}
+		}
+	}
+}
+
+void CompilerProfile::clear()
+{
+	mPhases.clear();
+	mHeaders.clear();
+	mInstantiations.clear();
+	mReportSection.clear();
+}
+
+bool CompilerProfile::isEmpty() const
+{
+	return mPhases.empty() && mHeaders.empty() && mInstantiations.empty();
+}
+
+std::vector<CompilerProfile::Entry> CompilerProfile::getEntries( Category category, size_t maxEntries ) const
+{
+	std::vector<Entry> entries;
+	for( const auto &entry : getCategory( category ) ) {
+		entries.push_back( entry.second );
+	}
+	auto last = entries.begin() + std::min( maxEntries, entries.size() );
+	std::partial_sort( entries.begin(), last, entries.end(), []( const Entry &a, const Entry &b ) { return a.mDuration > b.mDuration; } );
+	entries.erase( last, entries.end() );
+	return entries;
+}
+
+std::string CompilerProfile::printToString( size_t maxEntries ) const
+{
+	stringstream str;
+	const std::pair<Category,const char*> categories[] = { { Category::Phase, "Phases" }, { Category::Header, "Headers" }, { Category::Instantiation, "Instantiations" } };
+	for( const auto &category : categories ) {
+		auto entries = getEntries( category.first, maxEntries );
+		if( entries.empty() ) {
+			continue;
+		}
+		str << category.second << ":" << endl;
+		for( const auto &entry : entries ) {
+			str << "\t" << ( entry.mDuration.count() / 1000.0 ) << "ms\t(" << entry.mCount << "x)\t" << entry.mName << endl;
+		}
+	}
+	return str.str();
+}
+
+namespace {
+	//! Converts seconds written as text to microseconds
+	std::chrono::microseconds parseSeconds( std::string_view str )
+	{
+		return std::chrono::microseconds( static_cast<int64_t>( std::strtod( std::string( str ).c_str(), nullptr ) * 1000000.0 ) );
+	}
+} // anonymous namespace
+
+bool CompilerProfile::parseReportTimeLine( std::string_view line )
+{
+	while( ! line.empty() && ( line.back() == '\r' || line.back() == ' ' ) ) {
+		line.remove_suffix( 1 );
+	}
+
+	// /Bt+: "time(C:\...\c1xx.dll)=0.52310s < 1234 - 5678 > BB [C:\src\Source.cpp]"
+	if( line.compare( 0, 5, "time(" ) == 0 ) {
+		size_t end = line.find( ")=" );
+		if( end == std::string_view::npos ) {
+			return false;
+		}
+		// the passes are named after their dll, ex. "c1xx" for the frontend and "c2" for the backend
+		auto tool = line.substr( 5, end - 5 );
+		tool.remove_prefix( std::min( tool.find_last_of( "\\/" ) + 1, tool.size() ) );
+		add( Category::Phase, std::string( tool.substr( 0, tool.rfind( '.' ) ) ), parseSeconds( line.substr( end + 2 ) ) );
+		return true;
+	}
+
+	// /d1reportTime: section titles followed by indented "Count: n" and "name: 0.0123s" lines, nested headers being indented further
+	if( line == "Include Headers:" || line == "Class Definitions:" || line == "Function Definitions:" ) {
+		mReportSection = std::string( line );
+		return true;
+	}
+	if( mReportSection.empty() ) {
+		return false;
+	}
+	if( line.empty() || line.front() != '\t' ) {
+		mReportSection.clear();
+		return false;
+	}
+	line.remove_prefix( std::min( line.find_first_not_of( '\t' ), line.size() ) );
+	size_t separator = line.rfind( ": " );
+	if( separator != std::string_view::npos && line.compare( 0, separator, "Count" ) != 0 && line.back() == 's' ) {
+		add( mReportSection == "Include Headers:" ? Category::Header : Category::Instantiation, std::string( line.substr( 0, separator ) ), parseSeconds( line.substr( separator + 2 ) ) );
+	}
+	return true;
+}
+
+namespace {
+	//! Reads the members of the json object at the reader position, the members of the objects nested in it being flattened
+	void readJsonObject( JsonReader &reader, std::map<std::string,std::string>* members )
+	{
+		reader.expect( '{' );
+		if( reader.skip( '}' ) ) {
+			return;
+		}
+		std::string key;
+		do {
+			key.clear();
+			reader.readString( &key );
+			reader.expect( ':' );
+			const char c = reader.peek();
+			if( c == '"' ) {
+				auto &value = (*members)[key];
+				value.clear();
+				reader.readString( &value );
+			}
+			else if( c == '{' ) {
+				readJsonObject( reader, members );
+			}
+			else if( c == '[' ) {
+				reader.skipValue();
+			}
+			else {
+				reader.readLiteral( &(*members)[key] );
+			}
+		} while( reader.skip( ',' ) );
+		reader.expect( '}' );
+	}
+} // anonymous namespace
+
+bool CompilerProfile::readTimeTrace( const ci::fs::path &path )
+{
+	ifstream file( path, ios::binary );
+	if( ! file ) {
+		return false;
+	}
+	const string json( ( istreambuf_iterator<char>( file ) ), istreambuf_iterator<char>() );
+
+	// {"traceEvents":[{"pid":1,"tid":0,"ph":"X","ts":12,"dur":345,"name":"Source","args":{"detail":"Header.h"}},...],"beginningOfTime":0}
+	JsonReader reader( path, json.data(), json.size() );
+	try {
+		reader.expect( '{' );
+		if( reader.skip( '}' ) ) {
+			return true;
+		}
+		string key;
+		std::map<std::string,std::string> event;
+		do {
+			key.clear();
+			reader.readString( &key );
+			reader.expect( ':' );
+			if( key != "traceEvents" ) {
+				reader.skipValue();
+				continue;
+			}
+			reader.expect( '[' );
+			if( reader.skip( ']' ) ) {
+				continue;
+			}
+			do {
+				event.clear();
+				readJsonObject( reader, &event );
+				if( event["ph"] != "X" ) {
+					continue;
+				}
+				const auto &name = event["name"];
+				const auto duration = std::chrono::microseconds( std::strtoll( event["dur"].c_str(), nullptr, 10 ) );
+				if( name == "Source" ) {
+					add( Category::Header, event["detail"], duration );
+				}
+				else if( name == "InstantiateClass" || name == "InstantiateFunction" ) {
+					add( Category::Instantiation, event["detail"], duration );
+				}
+				else if( name == "Frontend" || name == "Backend" ) {
+					add( Category::Phase, name, duration );
+				}
+			} while( reader.skip( ',' ) );
+			reader.expect( ']' );
+		} while( reader.skip( ',' ) );
+		reader.expect( '}' );
+	}
+	catch( const JsonReaderException & ) {
+		// truncated or malformed trace, the events read until then are kept
+		return false;
+	}
+	return true;
+}
+
+} // namespace runtime
@@ -0,0 +1,191 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "runtime/Diagnostic.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace runtime {
+
+Diagnostic::Diagnostic()
+: mSeverity( Severity::Note ), mLine( 0 ), mColumn( 0 )
+{
+}
+
+Diagnostic::Diagnostic( Severity severity, const ci::fs::path &file, int line, int column, const std::string &code, const std::string &message )
+: mSeverity( severity ), mFile( file ), mLine( line ), mColumn( column ), mCode( code ), mMessage( message )
+{
+}
+
+namespace {
+	
+	bool startsWith( string_view s, string_view prefix )
+	{
+		return s.size() >= prefix.size() && s.compare( 0, prefix.size(), prefix ) == 0;
+	}
+
+	string_view trim( string_view s )
+	{
+		while( ! s.empty() && ( s.front() == ' ' || s.front() == '\t' ) ) s.remove_prefix( 1 );
+		while( ! s.empty() && ( s.back() == ' ' || s.back() == '\t' || s.back() == '\r' ) ) s.remove_suffix( 1 );
+		return s;
+	}
+
+	//! Parses s as a positive integer, returns false if s contains anything else
+	bool parseNumber( string_view s, int* number )
+	{
+		if( s.empty() || s.size() > 9 ) {
+			return false;
+		}
+		int result = 0;
+		for( char c : s ) {
+			if( c < '0' || c > '9' ) {
+				return false;
+			}
+			result = result * 10 + ( c - '0' );
+		}
+		*number = result;
+		return true;
+	}
+
+	//! Splits "file(line)", "file(line,column)", "file:line" or "file:line:column" into its parts
+	void parseLocation( string_view location, ci::fs::path* file, int* line, int* column )
+	{
+		location = trim( location );
+		// msvc style
+		if( ! location.empty() && location.back() == ')' ) {
+			size_t open = location.rfind( '(' );
+			if( open != string_view::npos ) {
+				string_view position = location.substr( open + 1, location.size() - open - 2 );
+				size_t comma = position.find( ',' );
+				if( parseNumber( position.substr( 0, comma ), line ) ) {
+					if( comma != string_view::npos ) {
+						parseNumber( position.substr( comma + 1 ), column );
+					}
+				}
+				// the section of an object file the linker complains about (ex. file.cpp:(.text+0x1c))
+				location = location.substr( 0, open );
+				if( ! location.empty() && location.back() == ':' ) {
+					location.remove_suffix( 1 );
+				}
+			}
+		}
+		// gcc and clang style, the numbers are taken from the end as windows paths contain colons
+		else {
+			int numbers[2];
+			size_t count = 0;
+			size_t colon;
+			while( count < 2 && ( colon = location.rfind( ':' ) ) != string_view::npos && parseNumber( location.substr( colon + 1 ), &numbers[count] ) ) {
+				location = location.substr( 0, colon );
+				++count;
+			}
+			if( count == 2 ) {
+				*line = numbers[1];
+				*column = numbers[0];
+			}
+			else if( count == 1 ) {
+				*line = numbers[0];
+			}
+		}
+		*file = ci::fs::path( string( trim( location ) ) );
+	}
+
+} // anonymous namespace
+
+bool Diagnostic::parse( std::string_view line, Diagnostic* diagnostic )
+{
+	// the severity always follows the location and a colon: jump from one colon to the next instead of
+	// searching the whole line for keywords, which also stops early on the long lines of template errors
+	const char* begin = line.data();
+	const char* end = begin + line.size();
+	for( const char* colon = static_cast<const char*>( memchr( begin, ':', line.size() ) ); colon; colon = static_cast<const char*>( memchr( colon + 1, ':', end - colon - 1 ) ) ) {
+		string_view rest( colon + 1, end - colon - 1 );
+		if( rest.empty() || rest.front() != ' ' ) {
+			continue;
+		}
+		rest = trim( rest );
+		
+		// linker errors without a severity (ex. file.cpp:(.text+0x1c): undefined reference to `foo()')
+		if( startsWith( rest, "undefined reference to " ) || startsWith( rest, "multiple definition of " ) ) {
+			*diagnostic = Diagnostic( Severity::Error, {}, 0, 0, "", string( rest ) );
+			parseLocation( string_view( begin, colon - begin ), &diagnostic->mFile, &diagnostic->mLine, &diagnostic->mColumn );
+			return true;
+		}
+
+		// msvc prefixes the severity of the driver diagnostics (ex. cl : Command line warning D9002 : ...)
+		if( startsWith( rest, "Command line " ) ) {
+			rest.remove_prefix( 13 );
+		}
+		Severity severity;
+		if( startsWith( rest, "fatal error" ) ) {
+			severity = Severity::FatalError;
+			rest.remove_prefix( 11 );
+		}
+		else if( startsWith( rest, "error" ) ) {
+			severity = Severity::Error;
+			rest.remove_prefix( 5 );
+		}
+		else if( startsWith( rest, "warning" ) ) {
+			severity = Severity::Warning;
+			rest.remove_prefix( 7 );
+		}
+		else if( startsWith( rest, "note" ) ) {
+			severity = Severity::Note;
+			rest.remove_prefix( 4 );
+		}
+		else {
+			continue;
+		}
+
+		// msvc codes sit between the severity and the colon (ex. error C2065: or warning D9002 :)
+		string_view code;
+		if( ! rest.empty() && rest.front() == ' ' ) {
+			size_t codeEnd = rest.find( ':' );
+			code = trim( rest.substr( 0, codeEnd ) );
+			if( codeEnd == string_view::npos || code.empty() || code.find( ' ' ) != string_view::npos ) {
+				continue;
+			}
+			rest.remove_prefix( codeEnd );
+		}
+		if( rest.empty() || rest.front() != ':' ) {
+			continue;
+		}
+		string_view message = trim( rest.substr( 1 ) );
+
+		// gcc and clang end warnings with the flag controlling them (ex. [-Wunused-variable]), other brackets are part of the message (ex. [with T = int])
+		if( code.empty() && ! message.empty() && message.back() == ']' ) {
+			size_t open = message.rfind( " [" );
+			if( open != string_view::npos && message.compare( open + 2, 2, "-W" ) == 0 ) {
+				code = message.substr( open + 2, message.size() - open - 3 );
+				message = message.substr( 0, open );
+			}
+		}
+
+		*diagnostic = Diagnostic( severity, {}, 0, 0, string( code ), string( message ) );
+		parseLocation( string_view( begin, colon - begin ), &diagnostic->mFile, &diagnostic->mLine, &diagnostic->mColumn );
+		return true;
+	}
+	return false;
+}
+
+} // namespace runtime
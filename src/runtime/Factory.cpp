@@ -20,6 +20,9 @@
 */
 
 #include "runtime/Factory.h"
+#include "runtime/BuildLog.h"
+#include "runtime/ProjectConfiguration.h"
+#include "runtime/SourceFingerprint.h"
 #include "cinder/app/App.h"
 #include "cinder/Log.h"
 
@@ -33,6 +36,29 @@ Factory& Factory::instance()
 	static Factory factory;
 	return factory;
 }
+
+Factory::Factory()
+	: mBuildDelay( 100 ), mNumSkippedBuilds( 0 ), mMaxPrebuilds( 32 ), mNumPrebuilds( 0 )
+{
+	mUpdateConnection = app::App::get()->getSignalUpdate().connect( bind( &Factory::update, this ) );
+	// the build log is a static too, stop it while the console still exists
+	mCleanupConnection = app::App::get()->getSignalCleanup().connect( []() { rt::BuildLog::instance().shutdown(); } );
+}
+rt::BuildSettings Factory::getDefaultBuildSettings( const ci::fs::path &sourcePath )
+{
+#if defined( CINDER_MSW )
+	return rt::BuildSettings().vcxproj();
+#else
+	// the includes, defines and code generation of the app come from the compilation database CMake writes to the build directory
+	rt::BuildSettings settings;
+	const auto buildDir = rt::ProjectConfiguration::instance().getBuildDir();
+	if( ! sourcePath.empty() && ! buildDir.empty() && fs::exists( buildDir / "compile_commands.json" ) ) {
+		settings.compileCommands( sourcePath );
+	}
+	return settings;
+#endif
+}
+
 Factory::TypeFormat& Factory::TypeFormat::precompiledHeader( bool generate )
 {
 	mPrecompiledHeader = generate;
@@ -55,6 +81,24 @@ Factory::TypeFormat& Factory::TypeFormat::linkAppObjs( bool link )
 	return *this;
 }
 
+Factory::TypeFormat& Factory::TypeFormat::linkAppExports( bool link )
+{
+	mLinkAppExports = link;
+	return *this;
+}
+
+Factory::TypeFormat& Factory::TypeFormat::unityBuild( bool enable )
+{
+	mUnityBuild = enable;
+	return *this;
+}
+
+Factory::TypeFormat& Factory::TypeFormat::prebuild( bool enable )
+{
+	mPrebuild = enable;
+	return *this;
+}
+
 namespace {
 
 	static std::string stripNamespace( const std::string &className )
@@ -75,7 +119,7 @@ void* Factory::allocate( size_t size, const std::type_index &typeIndex )
 		const auto &type = mTypes[typeIndex];
 		const auto &module = type.getModule();
 		if( module && module->getSymbolAddress( "rt_" + module->getName() + "_new_operator" ) ) {
-			auto newOperator = static_cast<void*(__cdecl*)(const std::string &)>( module->getSymbolAddress( "rt_" + module->getName() + "_new_operator" ) );
+			auto newOperator = reinterpret_cast<void*(*)(const std::string &)>( module->getSymbolAddress( "rt_" + module->getName() + "_new_operator" ) );
 			return newOperator( type.getName() );
 		}
 	}
@@ -112,6 +156,9 @@ void Factory::watchImpl( const std::type_index &typeIndex, void* address, const
 				if( path.extension() == ".h" || path.extension() == ".hpp" ) {
 					codeGenOptions.include( path.filename().string() ); // TODO: better handling of include path (ex. #include "folder/file.h" would not work)
 				}
+				else if( format.mUnityBuild && path.extension() == ".cpp" ) {
+					codeGenOptions.unitySource( path );
+				}
 			}
 			settings.preBuildStep( make_shared<rt::CodeGeneration>( codeGenOptions ) );
 		}
@@ -134,7 +181,16 @@ void Factory::watchImpl( const std::type_index &typeIndex, void* address, const
 			settings.preBuildStep( make_shared<rt::ModuleDefinition>( rt::ModuleDefinition::Options().exportVftable( name ) ) );
 		}
 
-		if( format.mLinkAppObjs ) {
+		// the settings of most types only differ by their module and build steps
+		settings.intern();
+
+		// the prebuild only needs the generated sources
+		auto prebuildSettings = settings;
+
+		if( format.mLinkAppExports ) {
+			settings.preBuildStep( make_shared<rt::LinkAppExports>() );
+		}
+		else if( format.mLinkAppObjs ) {
 			settings.preBuildStep( make_shared<rt::LinkAppObjs>() );
 		}
 
@@ -145,6 +201,21 @@ void Factory::watchImpl( const std::type_index &typeIndex, void* address, const
 			Compiler::instance().debugLog( &settings );
 		}
 
+		// fingerprint the sources the current version has been built from
+		auto &request = mBuildRequests[typeIndex];
+		request.mFilePaths = filePaths;
+		request.mSettings = settings;
+		for( const auto &path : filePaths ) {
+			request.mFingerprints[path] = rt::SourceFingerprint::fromFile( path );
+		}
+
+		// and get the precompiled header ready before the first change
+		if( format.mPrebuild && mNumPrebuilds < mMaxPrebuilds ) {
+			request.mPrebuildSettings = prebuildSettings;
+			mPrebuildQueue.push_back( typeIndex );
+			++mNumPrebuilds;
+		}
+
 		// and start watching the source files
 		FileWatcher::instance().watch( filePaths, FileWatcher::Options().callOnWatch( false ), bind( &Factory::sourceChanged, this, placeholders::_1, typeIndex, filePaths, settings ) );
 	}
@@ -166,24 +237,192 @@ void Factory::sourceChanged( const WatchEvent &event, const std::type_index &typ
 	// unlock the dll-handle before building
 	//const auto &module = mTypes[typeIndex].getModule();
 	//module->unlockHandle();
-				
+	
+	// ignore saves that leave the token stream untouched (touch, reformatting or comment edits)
+	auto &request = mBuildRequests[typeIndex];
+	const uint64_t fingerprint = rt::SourceFingerprint::fromFile( event.getFile() );
+	auto &previousFingerprint = request.mFingerprints[event.getFile()];
+	if( fingerprint && fingerprint == previousFingerprint ) {
+		if( ! request.mPending ) {
+			++mNumSkippedBuilds;
+			if( settings.isVerboseEnabled() ) {
+				CI_LOG_I( event.getFile().filename() << " only changed in whitespace or comments, skipping build" );
+			}
+		}
+		return;
+	}
+	previousFingerprint = fingerprint;
+
+	queueBuild( typeIndex, event.getFile().extension() == ".h" || event.getFile().extension() == ".hpp", std::chrono::steady_clock::now() + mBuildDelay );
+}
+
+void Factory::dependencyChanged( const WatchEvent &event )
+{
+	auto dependencyIt = mDependencies.find( event.getFile() );
+	if( dependencyIt == mDependencies.end() ) {
+		return;
+	}
+
+	auto &dependency = dependencyIt->second;
+	const uint64_t fingerprint = rt::SourceFingerprint::fromFile( event.getFile() );
+	if( fingerprint && fingerprint == dependency.mFingerprint ) {
+		for( const auto &typeIndex : dependency.mTypes ) {
+			if( ! mBuildRequests[typeIndex].mPending ) {
+				++mNumSkippedBuilds;
+			}
+		}
+		return;
+	}
+	dependency.mFingerprint = fingerprint;
+
+	// the types including the header share the same deadline so that their builds are started in the same update
+	const auto deadline = std::chrono::steady_clock::now() + mBuildDelay;
+	for( const auto &typeIndex : dependency.mTypes ) {
+		queueBuild( typeIndex, true, deadline );
+	}
+}
+
+void Factory::queueBuild( const std::type_index &typeIndex, bool headerChanged, const std::chrono::steady_clock::time_point &deadline )
+{
+	// bursts of changes are merged in a single build once the sources stop changing
+	auto &request = mBuildRequests[typeIndex];
+	request.mPending = true;
+	if( headerChanged ) {
+		request.mHeaderChanged = true;
+	}
+	request.mDeadline = deadline;
+
+	// the build in progress is building outdated sources
+	if( request.mBuildId ) {
+		rt::Compiler::instance().cancel( request.mBuildId );
+		request.mBuildId = 0;
+	}
+}
+
+void Factory::update()
+{
+	auto now = std::chrono::steady_clock::now();
+	bool building = false;
+	for( auto &request : mBuildRequests ) {
+		// a build waits for the prebuild generating its precompiled header, whether it succeeds or not
+		if( request.second.mPrebuildId && ! rt::Compiler::instance().isBuilding( request.second.mPrebuildId ) ) {
+			request.second.mPrebuildId = 0;
+		}
+		// the build callback is only called on success, a failed build is over once the compiler forgets it
+		if( request.second.mBuildId && ! rt::Compiler::instance().isBuilding( request.second.mBuildId ) ) {
+			request.second.mBuildId = 0;
+		}
+		if( request.second.mPending && now >= request.second.mDeadline && ! request.second.mPrebuildId ) {
+			startBuild( request.first, &request.second );
+		}
+		building = building || request.second.mPending || request.second.mBuildId || request.second.mPrebuildId;
+	}
+
+	// prebuilds only use the compiler when it has nothing else to do
+	if( ! building ) {
+		startPrebuild();
+	}
+}
+
+void Factory::startPrebuild()
+{
+	while( ! mPrebuildQueue.empty() ) {
+		auto typeIndex = mPrebuildQueue.front();
+		mPrebuildQueue.pop_front();
+
+		auto &request = mBuildRequests[typeIndex];
+		// and don't compete with the app or the builds that will follow
+		auto settings = request.mPrebuildSettings;
+		settings.jobPriority( Process::Priority::Idle );
+		request.mPrebuildId = rt::Compiler::instance().prebuild( request.mFilePaths.front(), settings );
+		// the precompiled header might already be up to date
+		if( request.mPrebuildId ) {
+			break;
+		}
+	}
+}
+
+void Factory::startBuild( const std::type_index &typeIndex, BuildRequest* request )
+{
+	request->mPending = false;
+
 	// force precompiled-header re-generation on header change
-	rt::BuildSettings buildSettings = settings;
-	if( event.getFile().extension() == ".h" ) {
+	rt::BuildSettings buildSettings = request->mSettings;
+	if( request->mHeaderChanged ) {
 		buildSettings.createPrecompiledHeader();
 	}
 	
-	// initiate the build
+	// initiate the build. the header flag of a cancelled or failed build carries over to the next one
 	const auto &type = mTypes[typeIndex];
-	rt::CompilerMsvc::instance().build( filePaths.front(), buildSettings, 
-		bind( &Factory::handleBuild, this, placeholders::_1, typeIndex, ( event.getFile().extension() == ".cpp" ? rt::ModuleDefinition::getVftableSymbol( type.getName() ) : "" ) ) );
+	std::string vtableSym = request->mHeaderChanged ? "" : rt::ModuleDefinition::getVftableSymbol( type.getName() );
+	request->mBuildId = rt::Compiler::instance().build( request->mFilePaths.front(), buildSettings, [this, typeIndex, vtableSym]( const rt::BuildOutput &output ) {
+		auto &request = mBuildRequests[typeIndex];
+		request.mBuildId = 0;
+		request.mHeaderChanged = false;
+		updateDependencies( typeIndex, output );
+		if( ! output.getCompilerProfile().isEmpty() ) {
+			mTypes[typeIndex].getCompilerProfile().merge( output.getCompilerProfile() );
+			if( output.getBuildSettings().isVerboseEnabled() ) {
+				CI_LOG_I( "Compiler profile of " << mTypes[typeIndex].getName() << ":\n" << output.getCompilerProfile().printToString() );
+			}
+		}
+		handleBuild( output, typeIndex, vtableSym );
+	} );
+}
+
+namespace {
+	//! Returns path as a string that can be compared to other paths, which are case insensitive on windows
+	std::string getComparablePath( const fs::path &path )
+	{
+		std::string comparable = path.generic_string();
+	#if defined( CINDER_MSW )
+		std::transform( comparable.begin(), comparable.end(), comparable.begin(), []( char c ) { return static_cast<char>( tolower( static_cast<unsigned char>( c ) ) ); } );
+	#endif
+		return comparable;
+	}
+} // anonymous namespace
+
+void Factory::updateDependencies( const std::type_index &typeIndex, const rt::BuildOutput &output )
+{
+	// a build coming from the cache compiled nothing, the previous dependencies still hold
+	if( output.getDependencies().empty() ) {
+		return;
+	}
+
+	auto &request = mBuildRequests[typeIndex];
+	for( const auto &path : request.mDependencies ) {
+		mDependencies[path].mTypes.erase( typeIndex );
+	}
+	request.mDependencies.clear();
+
+	// the type sources are already watched, and the generated ones are rewritten by every build
+	std::set<std::string> ignoredPaths;
+	for( const auto &path : request.mFilePaths ) {
+		ignoredPaths.insert( getComparablePath( path ) );
+	}
+	const std::string generatedDir = getComparablePath( output.getBuildSettings().getIntermediatePath() / "runtime" );
+
+	for( const auto &path : output.getDependencies() ) {
+		const std::string comparablePath = getComparablePath( path );
+		if( ignoredPaths.count( comparablePath ) || comparablePath.compare( 0, generatedDir.size(), generatedDir ) == 0 ) {
+			continue;
+		}
+
+		auto dependencyIt = mDependencies.find( path );
+		if( dependencyIt == mDependencies.end() ) {
+			dependencyIt = mDependencies.insert( { path, Dependency{ {}, rt::SourceFingerprint::fromFile( path ) } } ).first;
+			FileWatcher::instance().watch( path, FileWatcher::Options().callOnWatch( false ), bind( &Factory::dependencyChanged, this, placeholders::_1 ) );
+		}
+		dependencyIt->second.mTypes.insert( typeIndex );
+		request.mDependencies.push_back( path );
+	}
 }
 
 void Factory::handleBuild( const rt::BuildOutput &output, const std::type_index &typeIndex, const std::string &vtableSym )
 {
-	// if a new dll exists update the handle
+	// if a new dll exists, or the module has been linked in memory, update the handle
 	auto &type = mTypes[typeIndex];
-	if( fs::exists( output.getOutputPath() ) ) {
+	if( output.getSymbolLookup() || fs::exists( output.getOutputPath() ) ) {
 
 		// call cleanup / pre-build callbacks
 		type.getModule()->getCleanupSignal().emit( *type.getModule() );
@@ -194,11 +433,16 @@ void Factory::handleBuild( const rt::BuildOutput &output, const std::type_index
 			}
 		}
 		
-		// add this new version to the type versions list
-		type.getVersions().push_back( Type::Version( type.getVersions().size(), output.getOutputPath().parent_path() ) );
-
-		// swap module's dll
-		type.getModule()->updateHandle( output.getOutputPath() );
+		// swap module's dll, modules living in memory have no version on disk. The code of the 
+		// previous version living in memory is released at the end of the scope, once the instances have been updated
+		auto previousSymbolLookup = type.getModule()->getSymbolLookup();
+		if( output.getSymbolLookup() ) {
+			type.getModule()->updateHandle( output.getBuildSettings().getModuleName(), output.getSymbolLookup() );
+		}
+		else {
+			type.getVersions().push_back( Type::Version( type.getVersions().size(), output.getOutputPath().parent_path() ) );
+			type.getModule()->updateHandle( output.getOutputPath() );
+		}
 
 		// update the instances or swap vtables depending on which file has been modified
 		if( ! vtableSym.empty() ) {
@@ -223,6 +467,10 @@ void Factory::swapInstancesVtables( const std::type_index &typeIndex, const std:
 
 	// Find the address of the vtable
 	if( void* vtableAddress = module->getSymbolAddress( vtableSym ) ) {
+	#if ! defined( CINDER_MSW )
+		// itanium vtables start with the offset to the top of the object and the type info, objects point past them
+		vtableAddress = static_cast<char*>( vtableAddress ) + 2 * sizeof( void* );
+	#endif
 		for( size_t i = 0; i < instances.size(); ++i ) {
 		#if defined( CEREAL_CEREAL_HPP_ )
 			std::stringstream archiveStream;
@@ -247,7 +495,7 @@ void Factory::reconstructInstances( const std::type_index &typeIndex )
 	const auto &type = mTypes[typeIndex];
 	const auto &module = type.getModule();
 	const auto &instances = type.getInstances();
-	if( auto placementNewOperator = static_cast<void*(__cdecl*)(const std::string&,void*)>( module->getSymbolAddress( "rt" + module->getName() + "_placement_new_operator()" ) ) ) {
+	if( auto placementNewOperator = reinterpret_cast<void*(*)(const std::string&,void*)>( module->getSymbolAddress( "rt" + module->getName() + "_placement_new_operator()" ) ) ) {
 		// use placement new to construct new instances at the current instances addresses
 		for( size_t i = 0; i < instances.size(); ++i ) {
 		#if defined( CEREAL_CEREAL_HPP_ )
@@ -274,7 +522,7 @@ void Factory::reconstructInstances( const std::type_index &typeIndex )
 void Factory::loadTypeVersion( const std::type_index &typeIndex, const Type::Version &version )
 {
 	auto &type = mTypes[typeIndex];
-	if( fs::exists( version.getPath() / ( type.getName() + ".dll" ) ) ) {
+	if( fs::exists( version.getPath() / ( type.getName() + Module::getExtension() ) ) ) {
 			
 		// call cleanup / pre-build callbacks
 		type.getModule()->getCleanupSignal().emit( *type.getModule() );
@@ -286,7 +534,7 @@ void Factory::loadTypeVersion( const std::type_index &typeIndex, const Type::Ver
 		}
 
 		// swap module's dll
-		type.getModule()->updateHandle( version.getPath() / ( type.getName() + ".dll" ) );
+		type.getModule()->updateHandle( version.getPath() / ( type.getName() + Module::getExtension() ) );
 
 		// update the instances or swap vtables depending on which file has been modified
 		auto vtableSym = rt::ModuleDefinition::getVftableSymbol( type.getName() );
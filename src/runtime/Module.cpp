@@ -25,27 +25,28 @@
 #include <fstream>
 #include <sstream>
 
-#if ! defined( WIN32_LEAN_AND_MEAN )
-	#define WIN32_LEAN_AND_MEAN
+#if defined( CINDER_MSW )
+	#if ! defined( WIN32_LEAN_AND_MEAN )
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <Windows.h>
+#else
+	#include <dlfcn.h>
 #endif
 
-#include <Windows.h>
-
 using namespace std;
 using namespace ci;
 
 namespace runtime {
 
 Module::Module( const ci::fs::path &path )
-: mPath( path ), mName( path.stem().string() )
-#if defined( CINDER_MSW )
-, mHandle( nullptr )
-#endif
+: mHandle( nullptr ), mPath( path ), mName( path.stem().string() )
 {
 	if( fs::exists( path ) ) {
 #if defined( CINDER_MSW )
 		mHandle = LoadLibrary( mPath.wstring().c_str() );
 #else
+		mHandle = dlopen( mPath.c_str(), RTLD_NOW | RTLD_LOCAL );
 #endif
 	}
 }
@@ -56,6 +57,8 @@ Module::~Module()
 	if( mHandle ) {
 #if defined( CINDER_MSW )
 		FreeLibrary( static_cast<HINSTANCE>( mHandle ) );
+#else
+		dlclose( mHandle );
 #endif
 	}
 
@@ -78,15 +81,37 @@ void Module::updateHandle( const ci::fs::path &path )
 	}
 
 	if( fs::exists( mPath ) ) {
+		mSymbolLookup = nullptr;
 		if( mHandle != nullptr ) {
+#if defined( CINDER_MSW )
 			FreeLibrary( static_cast<HINSTANCE>( mHandle ) );
+#else
+			dlclose( mHandle );
+#endif
 		}
 #if defined( CINDER_MSW )
 		mHandle = LoadLibrary( mPath.wstring().c_str() );
+#else
+		mHandle = dlopen( mPath.c_str(), RTLD_NOW | RTLD_LOCAL );
 #endif
 	}
 }
 
+void Module::updateHandle( const std::string &name, const std::function<void*(const std::string&)> &symbolLookup )
+{
+	// the code stays in memory until the lookup is released, only the library handle needs to be freed
+	if( mHandle != nullptr ) {
+#if defined( CINDER_MSW )
+		FreeLibrary( static_cast<HINSTANCE>( mHandle ) );
+#else
+		dlclose( mHandle );
+#endif
+		mHandle = nullptr;
+	}
+	mName = name;
+	mSymbolLookup = symbolLookup;
+}
+
 void Module::unlockHandle()
 {
 	if( fs::exists( mPath ) ) {
@@ -112,6 +137,11 @@ Module::Handle Module::getHandle() const
 	return mHandle;
 }
 
+const std::function<void*(const std::string&)>& Module::getSymbolLookup() const
+{
+	return mSymbolLookup;
+}
+
 ci::fs::path Module::getPath() const
 {
 	return mPath;
@@ -128,12 +158,29 @@ std::string Module::getName() const
 
 bool Module::isValid() const
 {
-	return mHandle != nullptr;
+	return mHandle != nullptr || mSymbolLookup;
 }
 
 void* Module::getSymbolAddress( const std::string &symbol ) const
 {
+	if( mSymbolLookup ) {
+		return mSymbolLookup( symbol );
+	}
+#if defined( CINDER_MSW )
 	return (void*) GetProcAddress( static_cast<HMODULE>( mHandle ), symbol.c_str() );
+#else
+	return mHandle ? dlsym( mHandle, symbol.c_str() ) : nullptr;
+#endif
+}
+
+const std::string& Module::getExtension()
+{
+#if defined( CINDER_MSW )
+	static const std::string sExtension = ".dll";
+#else
+	static const std::string sExtension = ".so";
+#endif
+	return sExtension;
 }
 
 ci::signals::Signal<void( const Module& )>& Module::getCleanupSignal()
@@ -1,13 +1,20 @@
 #include "runtime/Process.h"
 
+#include <array>
+#include <map>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+
 #if ! defined( WIN32_LEAN_AND_MEAN )
 	#define WIN32_LEAN_AND_MEAN
 #endif
 
 #include <windows.h>
-#include <array>
-
-#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
 
 namespace {
 	//! Managed Handle class. Release handle on destruction
@@ -39,6 +46,213 @@ namespace {
 
 } // anonymous namespace
 #else
+
+#include <spawn.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sched.h>
+
+extern char **environ;
+
+// posix_spawn_file_actions_addchdir_np is available since glibc 2.29
+#if defined( __GLIBC__ ) && ( __GLIBC__ > 2 || ( __GLIBC__ == 2 && __GLIBC_MINOR__ >= 29 ) )
+	#define PROCESS_HAS_SPAWN_CHDIR
+#endif
+
+namespace {
+	//! Single epoll loop reading the StdOut and StdErr pipes of every Process.
+	//! Avoids having two blocking threads and two read buffers per child process.
+	class ProcessReader {
+	public:
+		//! Called when fd is readable. Returns false once the end of the file has been reached
+		using ReadFn = std::function<bool()>;
+		using CloseFn = std::function<void()>;
+
+		static ProcessReader& instance();
+
+		//! Starts watching a non-blocking fd. onClose is called from the reader thread after the last read
+		void add( int fd, const ReadFn &onRead, const CloseFn &onClose );
+		//! Stops watching fd. Once this returns no callbacks will be issued for this fd
+		void remove( int fd );
+		//! Temporarily stops polling fd, without unregistering its callbacks. Only meant to be called from a ReadFn
+		void pause( int fd );
+		//! Resumes polling a paused fd
+		void resume( int fd );
+
+		~ProcessReader();
+	protected:
+		ProcessReader();
+		void run();
+
+		struct Stream {
+			ReadFn	mOnRead;
+			CloseFn	mOnClose;
+		};
+
+		int						mEpoll;
+		int						mWakeup;
+		bool					mRunning;
+		std::mutex				mStreamsMutex;
+		std::map<int,Stream>	mStreams;
+		std::thread				mThread;
+	};
+
+	ProcessReader& ProcessReader::instance()
+	{
+		static ProcessReader reader;
+		return reader;
+	}
+
+	ProcessReader::ProcessReader()
+		: mEpoll( epoll_create1( EPOLL_CLOEXEC ) ), mWakeup( eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ), mRunning( true )
+	{
+		if( mEpoll == -1 || mWakeup == -1 ) {
+			throw ProcessExc( "Failed Creating Process Reader" );
+		}
+
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.fd = mWakeup;
+		epoll_ctl( mEpoll, EPOLL_CTL_ADD, mWakeup, &event );
+
+		mThread = std::thread( &ProcessReader::run, this );
+	}
+
+	ProcessReader::~ProcessReader()
+	{
+		mRunning = false;
+		uint64_t value = 1;
+		::write( mWakeup, &value, sizeof( value ) );
+		if( mThread.joinable() ) {
+			mThread.join();
+		}
+		close( mWakeup );
+		close( mEpoll );
+	}
+
+	void ProcessReader::add( int fd, const ReadFn &onRead, const CloseFn &onClose )
+	{
+		{
+			std::lock_guard<std::mutex> lock( mStreamsMutex );
+			mStreams[fd] = { onRead, onClose };
+		}
+
+		epoll_event event = {};
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.fd = fd;
+		if( epoll_ctl( mEpoll, EPOLL_CTL_ADD, fd, &event ) == -1 ) {
+			std::lock_guard<std::mutex> lock( mStreamsMutex );
+			mStreams.erase( fd );
+			throw ProcessExc( "Failed Watching Process Pipe" );
+		}
+	}
+
+	void ProcessReader::remove( int fd )
+	{
+		// callbacks are issued with mStreamsMutex locked, which means that
+		// none can be running or issued for this fd past this point
+		std::lock_guard<std::mutex> lock( mStreamsMutex );
+		if( mStreams.erase( fd ) ) {
+			epoll_ctl( mEpoll, EPOLL_CTL_DEL, fd, nullptr );
+		}
+	}
+
+	void ProcessReader::pause( int fd )
+	{
+		// the fd is removed from the interest list rather than modified to listen to no
+		// events, as EPOLLHUP would otherwise still be reported in a loop after the child exits
+		epoll_ctl( mEpoll, EPOLL_CTL_DEL, fd, nullptr );
+	}
+
+	void ProcessReader::resume( int fd )
+	{
+		epoll_event event = {};
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.fd = fd;
+		epoll_ctl( mEpoll, EPOLL_CTL_ADD, fd, &event );
+	}
+
+	void ProcessReader::run()
+	{
+		std::array<epoll_event, 64> events;
+		while( mRunning ) {
+			int numEvents = epoll_wait( mEpoll, events.data(), static_cast<int>( events.size() ), -1 );
+			if( numEvents == -1 ) {
+				if( errno == EINTR ) {
+					continue;
+				}
+				break;
+			}
+
+			std::lock_guard<std::mutex> lock( mStreamsMutex );
+			for( int i = 0; i < numEvents; ++i ) {
+				int fd = events[i].data.fd;
+				auto streamIt = mStreams.find( fd );
+				if( streamIt == mStreams.end() ) {
+					continue;
+				}
+
+				if( ! streamIt->second.mOnRead() ) {
+					epoll_ctl( mEpoll, EPOLL_CTL_DEL, fd, nullptr );
+					auto onClose = streamIt->second.mOnClose;
+					mStreams.erase( streamIt );
+					onClose();
+				}
+			}
+		}
+	}
+
+	//! Creates a pipe whose both ends are closed on exec. posix_spawn dup2 clears that flag on the child ends.
+	void createPipe( int fds[2], bool nonBlockingRead )
+	{
+		if( pipe2( fds, O_CLOEXEC ) == -1 ) {
+			throw ProcessExc( "Failed Creating Pipe" );
+		}
+		if( nonBlockingRead ) {
+			fcntl( fds[0], F_SETFL, fcntl( fds[0], F_GETFL ) | O_NONBLOCK );
+		}
+	}
+
+	void closeFd( int &fd )
+	{
+		if( fd != -1 ) {
+			close( fd );
+			fd = -1;
+		}
+	}
+
+	int16_t getExitCode( int status )
+	{
+		if( WIFEXITED( status ) ) {
+			return static_cast<int16_t>( WEXITSTATUS( status ) );
+		}
+		else if( WIFSIGNALED( status ) ) {
+			return static_cast<int16_t>( 128 + WTERMSIG( status ) );
+		}
+		return -1;
+	}
+
+#if ! defined( PROCESS_HAS_SPAWN_CHDIR )
+	std::string quoteShellArgument( const std::string &arg )
+	{
+		std::string output = "'";
+		for( char c : arg ) {
+			if( c == '\'' ) output += "'\\''";
+			else output += c;
+		}
+		return output + "'";
+	}
+#endif
+
+} // anonymous namespace
 #endif
 
 // https://support.microsoft.com/en-us/kb/190351
@@ -53,15 +267,408 @@ namespace {
 // random https://aljensencprogramming.wordpress.com/tag/createprocess/
 // namedpipes https://msdn.microsoft.com/en-us/library/aa365603(VS.85).aspx
 // namedpipes https://www.daniweb.com/programming/software-development/threads/295780/using-named-pipes-with-asynchronous-i-o-redirection-to-winapi
+// posix_spawn http://man7.org/linux/man-pages/man3/posix_spawn.3.html
+// epoll http://man7.org/linux/man-pages/man7/epoll.7.html
+
+struct Process::Stream {
+	Stream( size_t capacity, bool accumulate );
+
+	// Reader side
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	//! Blocking read loop, runs on mThread until the pipe is closed
+	void readLoop();
+#else
+	//! Reads until the pipe would block, the buffer is full or the end of file. Returns false once the pipe is closed
+	bool readAvailable();
+#endif
+	//! Publishes size bytes written at data in the buffer write region
+	void produce( const char* data, size_t size );
+	//! Keeps a copy of data that didn't fit in the buffer (only when discarding)
+	void drop( const char* data, size_t size );
+	//! Called when the buffer is full. Returns whether the reader should stop until resume() is called
+	bool pause();
+	//! Called once the child closed its end of the pipe
+	void close();
+
+	// Consumer side
+	//! Returns everything available and resumes the reader if it was waiting for space
+	std::string read();
+	//! Reads until the reader closes the stream
+	std::string readSync();
+	//! Splits what's available in lines and passes them to lineFn
+	size_t readLines( const std::function<void(std::string_view)> &lineFn );
+	//! Resumes a paused reader
+	void resume();
+	//! Stops applying backpressure. Whatever doesn't fit in the buffer from now on is dropped
+	void discard();
+	//! Waits for the reader to close the stream
+	void waitClosed();
+
+	rt::RingBuffer			mBuffer;
+	bool					mAccumulate;
+	//! Only touched by the reader until mClosed is set
+	std::string				mAccumulated;
+	//! Consumer side storage for lines that can't be viewed in place: lines wrapping around the end of the buffer or longer than its capacity
+	std::string				mLine;
+	std::atomic<bool>		mPaused;
+	std::atomic<bool>		mDiscard;
+	std::atomic<bool>		mClosed;
+	std::atomic<bool>		mSyncWaiting;
+	//! Only used on the slow paths: pausing / resuming the reader and waiting for data in readSync
+	std::mutex				mMutex;
+	std::condition_variable	mCond;
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	void*					mRead;
+	std::thread				mThread;
+#else
+	int						mRead;
+#endif
+};
+
+Process::Stream::Stream( size_t capacity, bool accumulate )
+	: mBuffer( capacity ), mAccumulate( accumulate ), mPaused( false ), mDiscard( false ), mClosed( false ), mSyncWaiting( false ),
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	mRead( nullptr )
+#else
+	mRead( -1 )
+#endif
+{
+}
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+void Process::Stream::readLoop()
+{
+	std::array<char, 4096> scratch;
+	while( true ) {
+		DWORD readBytes;
+		auto region = mBuffer.getWriteRegion();
+		if( region.getSize() > 0 ) {
+			// read in place into the buffer
+			if( ! ReadFile( mRead, region.mFirst, static_cast<DWORD>( region.mFirstSize ), &readBytes, nullptr ) || readBytes == 0 ) {
+				break;
+			}
+			produce( region.mFirst, readBytes );
+		}
+		else if( mDiscard ) {
+			if( ! ReadFile( mRead, scratch.data(), static_cast<DWORD>( scratch.size() ), &readBytes, nullptr ) || readBytes == 0 ) {
+				break;
+			}
+			drop( scratch.data(), readBytes );
+		}
+		else {
+			pause();
+		}
+	}
+	close();
+}
+#else
+bool Process::Stream::readAvailable()
+{
+	std::array<char, 4096> scratch;
+	while( true ) {
+		ssize_t readBytes;
+		auto region = mBuffer.getWriteRegion();
+		if( region.getSize() > 0 ) {
+			// read in place into the buffer, including the part wrapping around its end
+			iovec regions[2] = { { region.mFirst, region.mFirstSize }, { region.mSecond, region.mSecondSize } };
+			readBytes = readv( mRead, regions, region.mSecondSize ? 2 : 1 );
+			if( readBytes > 0 ) {
+				size_t first = std::min( static_cast<size_t>( readBytes ), region.mFirstSize );
+				if( mAccumulate ) {
+					mAccumulated.append( region.mFirst, first );
+					mAccumulated.append( region.mSecond, static_cast<size_t>( readBytes ) - first );
+				}
+				produce( nullptr, static_cast<size_t>( readBytes ) );
+				continue;
+			}
+		}
+		else if( mDiscard ) {
+			readBytes = ::read( mRead, scratch.data(), scratch.size() );
+			if( readBytes > 0 ) {
+				drop( scratch.data(), static_cast<size_t>( readBytes ) );
+				continue;
+			}
+		}
+		else if( pause() ) {
+			return true;
+		}
+		else {
+			continue;
+		}
+
+		if( readBytes == -1 && errno == EINTR ) {
+			continue;
+		}
+		return readBytes == -1 && ( errno == EAGAIN || errno == EWOULDBLOCK );
+	}
+}
+#endif
+
+void Process::Stream::produce( const char* data, size_t size )
+{
+	if( mAccumulate && data ) {
+		mAccumulated.append( data, size );
+	}
+	mBuffer.commit( size );
+
+	if( mSyncWaiting.load() ) {
+		std::lock_guard<std::mutex> lock( mMutex );
+		mCond.notify_all();
+	}
+}
+
+void Process::Stream::drop( const char* data, size_t size )
+{
+	if( mAccumulate ) {
+		mAccumulated.append( data, size );
+	}
+}
+
+bool Process::Stream::pause()
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+	// publish the paused state before checking the buffer one last time. This pairs with the
+	// fence in resume() so that either we see the space freed or the consumer sees mPaused
+	mPaused.store( true );
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	if( ! mBuffer.isFull() || mDiscard ) {
+		mPaused.store( false );
+		return false;
+	}
+	
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	mCond.wait( lock, [this]() { return ! mPaused.load() || mDiscard.load(); } );
+	mPaused.store( false );
+	return false;
+#else
+	ProcessReader::instance().pause( mRead );
+	return true;
+#endif
+}
+
+void Process::Stream::resume()
+{
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	if( mPaused.load() ) {
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( mPaused.load() ) {
+			mPaused.store( false );
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+			mCond.notify_all();
+#else
+			ProcessReader::instance().resume( mRead );
+#endif
+		}
+	}
+}
+
+void Process::Stream::close()
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	mClosed.store( true );
+	mCond.notify_all();
+}
+
+std::string Process::Stream::read()
+{
+	std::string output;
+	if( mBuffer.read( &output ) ) {
+		resume();
+	}
+	return output;
+}
+
+std::string Process::Stream::readSync()
+{
+	std::string output;
+	mSyncWaiting.store( true );
+	while( true ) {
+		bool closed = mClosed.load();
+		if( mBuffer.read( &output ) ) {
+			resume();
+		}
+		// the stream was closed before the last read, nothing else will come
+		if( closed ) {
+			break;
+		}
+		std::unique_lock<std::mutex> lock( mMutex );
+		mCond.wait( lock, [this]() { return mClosed.load() || ! mBuffer.isEmpty(); } );
+	}
+	mSyncWaiting.store( false );
+
+	// if enabled the accumulated output already contains what was just read
+	return mAccumulate ? mAccumulated : output;
+}
+
+size_t Process::Stream::readLines( const std::function<void(std::string_view)> &lineFn )
+{
+	// check whether the stream is closed before looking at the buffer; if it is, the buffer
+	// holds everything that will ever be written and the last line has to be flushed
+	bool closed = mClosed.load();
+	auto region = mBuffer.getReadRegion();
+	size_t numLines = 0;
+	size_t consumed = 0;
+
+	auto emit = [&]( std::string_view line ) {
+		if( ! line.empty() && line.back() == '\r' ) {
+			line.remove_suffix( 1 );
+		}
+		lineFn( line );
+		numLines++;
+	};
+
+	// returns the incomplete line at the end of data, if any
+	auto split = [&]( const char* data, size_t size ) -> std::string_view {
+		const char* end = data + size;
+		while( data < end ) {
+			auto newLine = static_cast<const char*>( std::memchr( data, '\n', end - data ) );
+			if( ! newLine ) {
+				break;
+			}
+			// finish a line started in mLine, otherwise view it in place
+			if( ! mLine.empty() ) {
+				mLine.append( data, newLine );
+				emit( mLine );
+				mLine.clear();
+			}
+			else {
+				emit( std::string_view( data, newLine - data ) );
+			}
+			consumed += newLine + 1 - data;
+			data = newLine + 1;
+		}
+		return std::string_view( data, end - data );
+	};
+
+	auto tail = split( region.mFirst, region.mFirstSize );
+	if( region.mSecondSize ) {
+		// a line wrapping around the end of the buffer can't be viewed in place
+		mLine.append( tail.data(), tail.size() );
+		consumed += tail.size();
+		tail = split( region.mSecond, region.mSecondSize );
+	}
+
+	// keep the incomplete last line in the buffer, unless it has already been started in mLine,
+	// the stream is closed, or it fills the whole buffer and would otherwise block the reader
+	if( ! tail.empty() && ( ! mLine.empty() || closed || ( consumed == 0 && region.getSize() == mBuffer.getCapacity() ) ) ) {
+		mLine.append( tail.data(), tail.size() );
+		consumed += tail.size();
+	}
+	if( closed && ! mLine.empty() ) {
+		emit( mLine );
+		mLine.clear();
+	}
+
+	if( consumed ) {
+		mBuffer.consume( consumed );
+		resume();
+	}
+	return numLines;
+}
+
+void Process::Stream::discard()
+{
+	mDiscard.store( true );
+	std::lock_guard<std::mutex> lock( mMutex );
+	if( mPaused.load() ) {
+		mPaused.store( false );
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+		mCond.notify_all();
+#else
+		ProcessReader::instance().resume( mRead );
+#endif
+	}
+}
+
+void Process::Stream::waitClosed()
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+	mCond.wait( lock, [this]() { return mClosed.load(); } );
+}
 
-Process::Process( const std::string &cmd, bool redirectOutput, bool redirectError, bool redirectInput ) : Process( cmd, "", redirectOutput, redirectError, redirectInput ) {}
+Process::Options::Options()
+	: mRedirectOutput( true ), mRedirectError( true ), mRedirectInput( true ), mAccumulateOutput( false ), mBufferCapacity( 65536 ), mPriority( Priority::Normal ), mAffinity( 0 )
+{
+}
+Process::Options& Process::Options::path( const std::string &path )
+{
+	mPath = path;
+	return *this;
+}
+Process::Options& Process::Options::redirectOutput( bool redirect )
+{
+	mRedirectOutput = redirect;
+	return *this;
+}
+Process::Options& Process::Options::redirectError( bool redirect )
+{
+	mRedirectError = redirect;
+	return *this;
+}
+Process::Options& Process::Options::redirectInput( bool redirect )
+{
+	mRedirectInput = redirect;
+	return *this;
+}
+Process::Options& Process::Options::accumulateOutput( bool accumulate )
+{
+	mAccumulateOutput = accumulate;
+	return *this;
+}
+Process::Options& Process::Options::bufferCapacity( size_t capacity )
+{
+	mBufferCapacity = capacity;
+	return *this;
+}
+Process::Options& Process::Options::environment( const std::vector<std::string> &variables )
+{
+	mEnvironment = variables;
+	return *this;
+}
+Process::Options& Process::Options::priority( Priority priority )
+{
+	mPriority = priority;
+	return *this;
+}
+Process::Options& Process::Options::affinity( uint64_t mask )
+{
+	mAffinity = mask;
+	return *this;
+}
+
+Process::Process( const std::string &cmd, bool redirectOutput, bool redirectError, bool redirectInput ) 
+: Process( cmd, Options().redirectOutput( redirectOutput ).redirectError( redirectError ).redirectInput( redirectInput ) ) {}
 Process::Process( const std::string &cmd, const std::string &path, bool redirectOutput, bool redirectError, bool redirectInput )
-: mIsOutputQueueEmpty( true ), mIsErrorQueueEmpty( true )
+: Process( cmd, Options().path( path ).redirectOutput( redirectOutput ).redirectError( redirectError ).redirectInput( redirectInput ) ) {}
+Process::Process( const std::string &cmd, const Options &options )
+: mProcessRunning( false ), mExitCode( -1 )
+{
+	initialize( cmd, {}, options );
+}
+Process::Process( const std::vector<std::string> &args, const Options &options )
+: mProcessRunning( false ), mExitCode( -1 )
 {
+	if( args.empty() ) {
+		throw ProcessExc( "Failed Creating Process: No Arguments" );
+	}
+	initialize( std::string(), args, options );
+}
+
+void Process::initialize( const std::string &cmd, const std::vector<std::string> &args, const Options &options )
+{
+	if( options.mRedirectOutput ) {
+		mOutput = std::make_unique<Stream>( options.mBufferCapacity, options.mAccumulateOutput );
+	}
+	if( options.mRedirectError ) {
+		mError = std::make_unique<Stream>( options.mBufferCapacity, options.mAccumulateOutput );
+	}
+	const bool redirectOutput = options.mRedirectOutput;
+	const bool redirectError = options.mRedirectError;
+	const bool redirectInput = options.mRedirectInput;
+	const std::string &path = options.mPath;
 
 #if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
-	mOutputRead = nullptr;
-	mErrorRead = nullptr;
 	mInputWrite = nullptr;
 	ManagedHandle outputRead;
 	ManagedHandle outputWrite;
@@ -120,18 +727,47 @@ Process::Process( const std::string &cmd, const std::string &path, bool redirect
 		startupInfo.hStdInput = inputRead;
 	}
 	
+	// Build the command line from the arguments when executing them directly
+	std::string commandLine = cmd;
+	for( const auto &arg : args ) {
+		commandLine += ( commandLine.empty() ? "" : " " ) + quoteArgument( arg );
+	}
+	std::wstring commandLineW( commandLine.begin(), commandLine.end() );
+	std::wstring applicationName = args.empty() ? std::wstring() : std::wstring( args.front().begin(), args.front().end() );
+
+	// The environment block is a list of null-terminated variables terminated by an additional null character
+	std::wstring environment;
+	for( const auto &variable : options.mEnvironment ) {
+		environment.append( variable.begin(), variable.end() );
+		environment.push_back( L'\0' );
+	}
+	environment.push_back( L'\0' );
+
 	// Initialize the new process
 	PROCESS_INFORMATION processInfo;
 	ZeroMemory( &processInfo, sizeof(processInfo) );
 	DWORD creationFlags = CREATE_UNICODE_ENVIRONMENT;//| CREATE_NEW_CONSOLE; //0;
-	if( ! CreateProcessW( nullptr,							// Application Name
-						 cmd.empty() ?						// Command Line
-						 nullptr : (LPWSTR) std::wstring( cmd.begin(), cmd.end() ).c_str(),	
+	// the below normal and idle classes are inherited by the processes the child starts
+	if( options.mPriority == Priority::BelowNormal ) {
+		creationFlags |= BELOW_NORMAL_PRIORITY_CLASS;
+	}
+	else if( options.mPriority == Priority::Idle ) {
+		creationFlags |= IDLE_PRIORITY_CLASS;
+	}
+	// the affinity is set before the child gets to run, and start processes that would otherwise not inherit it
+	if( options.mAffinity ) {
+		creationFlags |= CREATE_SUSPENDED;
+	}
+	if( ! CreateProcessW( applicationName.empty() ?			// Application Name
+						 nullptr : applicationName.c_str(),
+						 commandLineW.empty() ?				// Command Line
+						 nullptr : &commandLineW[0],
 						 nullptr,							// Process Attributes (If NULL, the handle cannot be inherited.)
 						 nullptr,							// Thread Attributes (If NULL, the handle cannot be inherited.)
 						 TRUE,								// Inherit Handles
 						 creationFlags,						// Creation Flags
-						 nullptr,							// Environment (If NULL, the new process uses the environment of the calling process.)
+						 options.mEnvironment.empty() ?		// Environment (If NULL, the new process uses the environment of the calling process.)
+						 nullptr : &environment[0],
 						 path.empty() ?						// Current Path (If NULL, the new process will have the same current drive and directory as the calling process.)
 						 nullptr : (LPWSTR) std::wstring( path.begin(), path.end() ).c_str(),	
 						 &startupInfo,						// Startup info
@@ -144,6 +780,10 @@ Process::Process( const std::string &cmd, const std::string &path, bool redirect
 		throw ProcessExc( "Failed Creating Process" );
 	}
 	else {
+		if( options.mAffinity ) {
+			SetProcessAffinityMask( processInfo.hProcess, static_cast<DWORD_PTR>( options.mAffinity ) );
+			ResumeThread( processInfo.hThread );
+		}
 		// Close ProcessInfo thread handle
 		CloseHandle( processInfo.hThread );
 		// And keep a reference to its process handle
@@ -153,70 +793,178 @@ Process::Process( const std::string &cmd, const std::string &path, bool redirect
 	
 	// Detach the temporary output handles and keep the read ends
 	if( redirectOutput ) {
-		mOutputRead = outputRead.detach();
+		mOutput->mRead = outputRead.detach();
 	}
 	if( redirectError ) {
-		mErrorRead = errorRead.detach();
+		mError->mRead = errorRead.detach();
 	}
 	if( redirectInput ) {
 		mInputWrite = inputWrite.detach();
 	}
 
-	// Create the async output read thread
+	// Create the async output and error read threads
 	if( redirectOutput ) {
-		mOutputReadThread = std::make_unique<std::thread>( [this]() {
-			std::promise<std::string> outputPromise;
-			mOutputFuture = outputPromise.get_future();
-			std::string outputStr;
-			DWORD readBytes;
-			std::array<char, 65536> buffer;
-			while( ReadFile( mOutputRead, buffer.data(), static_cast<DWORD>(65536), &readBytes, nullptr ) && readBytes != 0 ) {
-				// copy the buffer into a string
-				std::string output( buffer.begin(), buffer.begin() + readBytes );
-				// add the string to the sync output
-				outputStr += output;
-				// push the string to the async queue
-				std::lock_guard<std::mutex> queueLock( mOutputQueueMutex );
-				bool wasEmpty = mOutputQueue.empty();
-				mOutputQueue.push( output );
-				if( wasEmpty ) {
-					std::lock_guard<std::mutex> queueEmptyLock( mOutputQueueEmptyMutex );
-					mIsOutputQueueEmpty = false;
-				}
-			}
-			// send back the sync output
-			outputPromise.set_value( outputStr );
-		} );
+		mOutput->mThread = std::thread( &Stream::readLoop, mOutput.get() );
 	}
-
-	// Create the async error read thread
 	if( redirectError ) {
-		mErrorReadThread = std::make_unique<std::thread>( [this]() {
-			std::promise<std::string> errorPromise;
-			mErrorFuture = errorPromise.get_future();
-			std::string outputStr;
-			DWORD readBytes;
-			std::array<char, 65536> buffer;
-			while( ReadFile( mErrorRead, buffer.data(), static_cast<DWORD>(65536), &readBytes, nullptr ) && readBytes != 0 ) {
-				// copy the buffer into a string
-				std::string error( buffer.begin(), buffer.begin() + readBytes );
-				// add the string to the sync output
-				outputStr += error;
-				// push the string to the async queue
-				std::lock_guard<std::mutex> queueLock( mErrorQueueMutex );
-				bool wasEmpty = mErrorQueue.empty();
-				mErrorQueue.push( error );
-				if( wasEmpty ) {
-					std::lock_guard<std::mutex> queueEmptyLock( mErrorQueueEmptyMutex );
-					mIsErrorQueueEmpty = false;
-				}
-			}
-			// send back the sync output
-			errorPromise.set_value( outputStr );
-		} );
+		mError->mThread = std::thread( &Stream::readLoop, mError.get() );
 	}
 
 #else
+	mPid = -1;
+	mInputWrite = -1;
+	int outputPipe[2] = { -1, -1 };
+	int errorPipe[2] = { -1, -1 };
+	int inputPipe[2] = { -1, -1 };
+
+	auto closePipes = [&]() {
+		for( int *fd : { &outputPipe[0], &outputPipe[1], &errorPipe[0], &errorPipe[1], &inputPipe[0], &inputPipe[1] } ) {
+			closeFd( *fd );
+		}
+	};
+
+	try {
+		if( redirectOutput ) createPipe( outputPipe, true );
+		if( redirectError ) createPipe( errorPipe, true );
+		if( redirectInput ) createPipe( inputPipe, false );
+	}
+	catch( const ProcessExc & ) {
+		closePipes();
+		throw;
+	}
+
+	// Redirect the child ends of the pipes to StdIn, StdOut and StdErr
+	posix_spawn_file_actions_t fileActions;
+	posix_spawn_file_actions_init( &fileActions );
+	if( redirectOutput ) posix_spawn_file_actions_adddup2( &fileActions, outputPipe[1], STDOUT_FILENO );
+	if( redirectError ) posix_spawn_file_actions_adddup2( &fileActions, errorPipe[1], STDERR_FILENO );
+	if( redirectInput ) posix_spawn_file_actions_adddup2( &fileActions, inputPipe[0], STDIN_FILENO );
+
+	std::vector<std::string> spawnArgs;
+	if( args.empty() ) {
+		// Change the child current directory
+		std::string shellCmd = cmd;
+		if( ! path.empty() ) {
+#if defined( PROCESS_HAS_SPAWN_CHDIR )
+			posix_spawn_file_actions_addchdir_np( &fileActions, path.c_str() );
+#else
+			shellCmd = "cd " + quoteShellArgument( path ) + ( shellCmd.empty() ? " && exec /bin/sh" : " && " + shellCmd );
+#endif
+		}
+
+		// Spawn the process through the shell to keep the same command line semantic than CreateProcess
+		spawnArgs = { "/bin/sh" };
+		if( ! shellCmd.empty() ) {
+			spawnArgs.push_back( "-c" );
+			spawnArgs.push_back( shellCmd );
+		}
+	}
+	else {
+		if( ! path.empty() ) {
+#if defined( PROCESS_HAS_SPAWN_CHDIR )
+			posix_spawn_file_actions_addchdir_np( &fileActions, path.c_str() );
+#else
+			// no quoting needed, the path and arguments are passed to the shell as positional parameters
+			spawnArgs = { "/bin/sh", "-c", "cd \"$0\" && exec \"$@\"", path };
+#endif
+		}
+		spawnArgs.insert( spawnArgs.end(), args.begin(), args.end() );
+	}
+
+	std::vector<char*> argv;
+	for( auto &arg : spawnArgs ) {
+		argv.push_back( &arg[0] );
+	}
+	argv.push_back( nullptr );
+
+	std::vector<std::string> environment = options.mEnvironment;
+	std::vector<char*> envp;
+	for( auto &variable : environment ) {
+		envp.push_back( &variable[0] );
+	}
+	envp.push_back( nullptr );
+
+	// Start the child in its own process group so that kill() also reaches the processes it spawns
+	posix_spawnattr_t attributes;
+	posix_spawnattr_init( &attributes );
+	posix_spawnattr_setflags( &attributes, POSIX_SPAWN_SETPGROUP );
+	posix_spawnattr_setpgroup( &attributes, 0 );
+
+	// the child inherits the affinity of the spawning thread, which is only restricted for the duration of the call
+	cpu_set_t threadAffinity;
+	const bool restrictAffinity = options.mAffinity && sched_getaffinity( 0, sizeof( threadAffinity ), &threadAffinity ) == 0;
+	if( restrictAffinity ) {
+		cpu_set_t childAffinity;
+		CPU_ZERO( &childAffinity );
+		for( int cpu = 0; cpu < 64; ++cpu ) {
+			if( options.mAffinity & ( 1ull << cpu ) ) {
+				CPU_SET( cpu, &childAffinity );
+			}
+		}
+		sched_setaffinity( 0, sizeof( childAffinity ), &childAffinity );
+	}
+
+	pid_t pid;
+	int spawnError = posix_spawnp( &pid, argv.front(), &fileActions, &attributes, argv.data(), environment.empty() ? environ : envp.data() );
+	posix_spawn_file_actions_destroy( &fileActions );
+	posix_spawnattr_destroy( &attributes );
+	if( restrictAffinity ) {
+		sched_setaffinity( 0, sizeof( threadAffinity ), &threadAffinity );
+	}
+
+	// nice and io priority apply to the whole process group, the processes the child already started included.
+	// The processes it starts later inherit them
+	if( spawnError == 0 && options.mPriority != Priority::Normal ) {
+		const bool idle = options.mPriority == Priority::Idle;
+		setpriority( PRIO_PGRP, pid, idle ? 19 : 10 );
+		// IOPRIO_PRIO_VALUE( IOPRIO_CLASS_IDLE, 0 ) or IOPRIO_PRIO_VALUE( IOPRIO_CLASS_BE, 7 ), with IOPRIO_WHO_PGRP
+		syscall( SYS_ioprio_set, 2, pid, idle ? ( 3 << 13 ) : ( ( 2 << 13 ) | 7 ) );
+	}
+
+	// The child ends are not needed anymore in this process
+	closeFd( outputPipe[1] );
+	closeFd( errorPipe[1] );
+	closeFd( inputPipe[0] );
+
+	if( spawnError != 0 ) {
+		closePipes();
+		mProcessRunning = false;
+		throw ProcessExc( "Failed Creating Process" );
+	}
+
+	mPid = pid;
+	mProcessRunning = true;
+	mInputWrite = inputPipe[1];
+
+	// Register the read ends to the shared reader thread
+	for( auto stream : { std::make_pair( mOutput.get(), outputPipe[0] ), std::make_pair( mError.get(), errorPipe[0] ) } ) {
+		if( Stream* s = stream.first ) {
+			s->mRead = stream.second;
+		}
+	}
+	try {
+		for( Stream* s : { mOutput.get(), mError.get() } ) {
+			if( s ) {
+				ProcessReader::instance().add( s->mRead, [s]() { return s->readAvailable(); }, [s]() { s->close(); } );
+			}
+		}
+	}
+	catch( const ProcessExc & ) {
+		// The streams are freed while unwinding, unregister them before the reader thread can call them,
+		// then kill and reap the child as terminate() won't be called
+		for( Stream* s : { mOutput.get(), mError.get() } ) {
+			if( s ) {
+				ProcessReader::instance().remove( s->mRead );
+				closeFd( s->mRead );
+			}
+		}
+		closeFd( mInputWrite );
+		::kill( -mPid, SIGKILL );
+		int status;
+		while( waitpid( mPid, &status, 0 ) == -1 && errno == EINTR ) {}
+		mProcessRunning = false;
+		throw;
+	}
 #endif
 }
 
@@ -227,53 +975,138 @@ Process::~Process()
 
 std::string Process::getOutputSync()
 {
-	mOutputFuture.wait();
-	return mOutputFuture.get();
+	return mOutput ? mOutput->readSync() : std::string();
 }
 std::string Process::getErrorSync()
 {
-	mErrorFuture.wait();
-	return mErrorFuture.get();
+	return mError ? mError->readSync() : std::string();
 }
 
 std::string	Process::getOutputAsync()
 {
-	std::lock_guard<std::mutex> queueLock( mOutputQueueMutex );
-	if( ! mOutputQueue.empty() ) {
-		std::string output = mOutputQueue.front();
-		mOutputQueue.pop();
-		if( mOutputQueue.empty() ) {
-			std::lock_guard<std::mutex> queueEmptyLock( mOutputQueueEmptyMutex );
-			mIsOutputQueueEmpty = true;
-		}
-		return output;
-	}
-	return std::string();
+	return mOutput ? mOutput->read() : std::string();
 }
 std::string	Process::getErrorAsync()
 {
-	std::lock_guard<std::mutex> queueLock( mErrorQueueMutex );
-	if( ! mErrorQueue.empty() ) {
-		std::string error = mErrorQueue.front();
-		mErrorQueue.pop();
-		if( mErrorQueue.empty() ) {
-			std::lock_guard<std::mutex> queueEmptyLock( mErrorQueueEmptyMutex );
-			mIsErrorQueueEmpty = true;
+	return mError ? mError->read() : std::string();
+}
+
+size_t Process::readOutputLines( const std::function<void(std::string_view)> &lineFn )
+{
+	return mOutput ? mOutput->readLines( lineFn ) : 0;
+}
+size_t Process::readErrorLines( const std::function<void(std::string_view)> &lineFn )
+{
+	return mError ? mError->readLines( lineFn ) : 0;
+}
+
+bool Process::isOutputAvailable() const
+{
+	return mOutput && ! mOutput->mBuffer.isEmpty();
+}
+bool Process::isErrorAvailable() const
+{
+	return mError && ! mError->mBuffer.isEmpty();
+}
+bool Process::isOutputClosed() const
+{
+	return ! mOutput || ( mOutput->mClosed.load() && mOutput->mBuffer.isEmpty() && mOutput->mLine.empty() );
+}
+bool Process::isErrorClosed() const
+{
+	return ! mError || ( mError->mClosed.load() && mError->mBuffer.isEmpty() && mError->mLine.empty() );
+}
+
+bool Process::isRunning()
+{
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	if( mProcessRunning && WaitForSingleObject( mProcess, 0 ) != WAIT_TIMEOUT ) {
+		DWORD exitCodeDWORD;
+		if( GetExitCodeProcess( mProcess, &exitCodeDWORD ) ) {
+			mExitCode = static_cast<int16_t>( exitCodeDWORD );
 		}
-		return error;
+		CloseHandle( mProcess );
+		mProcessRunning = false;
 	}
-	return std::string();
+#else
+	if( mProcessRunning ) {
+		int status;
+		pid_t result;
+		do {
+			result = waitpid( mPid, &status, WNOHANG );
+		} while( result == -1 && errno == EINTR );
+		if( result == mPid ) {
+			mExitCode = getExitCode( status );
+			mProcessRunning = false;
+		}
+		else if( result == -1 ) {
+			mProcessRunning = false;
+		}
+	}
+#endif
+	return mProcessRunning;
 }
 
-bool Process::isOutputAvailable()
+void Process::kill()
 {
-	std::lock_guard<std::mutex> queueEmptyLock( mOutputQueueEmptyMutex );
-	return ! mIsOutputQueueEmpty;
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	if( mProcessRunning ) {
+		TerminateProcess( mProcess, 1 );
+	}
+#else
+	if( mProcessRunning ) {
+		::kill( -mPid, SIGKILL );
+	}
+#endif
+}
+
+// https://blogs.msdn.microsoft.com/twistylittlepassagesallalike/2011/04/23/everyone-quotes-command-line-arguments-the-wrong-way/
+std::string Process::quoteArgument( const std::string &arg )
+{
+	if( ! arg.empty() && arg.find_first_of( " \t\n\v\"" ) == std::string::npos ) {
+		return arg;
+	}
+
+	std::string output = "\"";
+	for( auto it = arg.begin(); ; ++it ) {
+		size_t numBackslashes = 0;
+		while( it != arg.end() && *it == '\\' ) {
+			++it;
+			++numBackslashes;
+		}
+		// backslashes are only escaped when followed by a quote, including the closing one
+		if( it == arg.end() ) {
+			output.append( numBackslashes * 2, '\\' );
+			break;
+		}
+		else if( *it == '"' ) {
+			output.append( numBackslashes * 2 + 1, '\\' );
+		}
+		else {
+			output.append( numBackslashes, '\\' );
+		}
+		output.push_back( *it );
+	}
+	return output + "\"";
 }
-bool Process::isErrorAvailable()
+
+std::vector<std::string> Process::getEnvironment()
 {
-	std::lock_guard<std::mutex> queueEmptyLock( mErrorQueueEmptyMutex );
-	return ! mIsErrorQueueEmpty;
+	std::vector<std::string> variables;
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	if( LPWCH environment = GetEnvironmentStringsW() ) {
+		for( LPWCH variable = environment; *variable; variable += wcslen( variable ) + 1 ) {
+			std::wstring variableW( variable );
+			variables.push_back( std::string( variableW.begin(), variableW.end() ) );
+		}
+		FreeEnvironmentStringsW( environment );
+	}
+#else
+	for( char **variable = environ; variable && *variable; ++variable ) {
+		variables.push_back( *variable );
+	}
+#endif
+	return variables;
 }
 
 bool Process::write( const std::string &cmd )
@@ -287,6 +1120,34 @@ bool Process::write( const std::string &cmd )
     }
   }
 #else
+	if( mInputWrite != -1 ) {
+		// block SIGPIPE on this thread so that writing to a child that
+		// already exited returns EPIPE instead of killing the app
+		sigset_t sigPipe, previousMask;
+		sigemptyset( &sigPipe );
+		sigaddset( &sigPipe, SIGPIPE );
+		pthread_sigmask( SIG_BLOCK, &sigPipe, &previousMask );
+
+		size_t written = 0;
+		while( written < cmd.length() ) {
+			ssize_t result = ::write( mInputWrite, cmd.data() + written, cmd.length() - written );
+			if( result == -1 && errno == EINTR ) {
+				continue;
+			}
+			else if( result <= 0 ) {
+				break;
+			}
+			written += static_cast<size_t>( result );
+		}
+
+		// consume the pending SIGPIPE if any before restoring the mask
+		if( written < cmd.length() && errno == EPIPE ) {
+			timespec timeout = { 0, 0 };
+			sigtimedwait( &sigPipe, nullptr, &timeout );
+		}
+		pthread_sigmask( SIG_SETMASK, &previousMask, nullptr );
+		return written == cmd.length() && written != 0;
+	}
 #endif
   return false;
 }
@@ -299,6 +1160,7 @@ void Process::closeInput()
 		mInputWrite = nullptr;
 	}
 #else
+	closeFd( mInputWrite );
 #endif
 }
 
@@ -308,42 +1170,61 @@ int16_t Process::terminate()
 	// closed already
 	closeInput();
 
+	// Nobody might be consuming the output anymore, make sure the child
+	// can't stay blocked on a full pipe while we wait for it to exit
+	for( Stream* stream : { mOutput.get(), mError.get() } ) {
+		if( stream ) {
+			stream->discard();
+		}
+	}
+
 	// Then wait for the Process to exit
-	int16_t exitCode = -1;
-	
 #if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
 	if( mProcessRunning ) {
 		WaitForSingleObject( mProcess, INFINITE );
 		// And get its exit code
 		DWORD exitCodeDWORD;
 		if( GetExitCodeProcess( mProcess, &exitCodeDWORD ) ) {
-			exitCode = static_cast<int16_t>( exitCodeDWORD );
+			mExitCode = static_cast<int16_t>( exitCodeDWORD );
 		}
 		// Close the Process Handle
 		CloseHandle( mProcess );
 		mProcessRunning = false;
 	}
-#endif
 
-	// Join Threads
-	if( mOutputReadThread && mOutputReadThread->joinable() ) {
-		mOutputReadThread->join();
+	// Join Threads and Close Handles
+	for( Stream* stream : { mOutput.get(), mError.get() } ) {
+		if( stream && stream->mThread.joinable() ) {
+			stream->mThread.join();
+		}
+		if( stream && stream->mRead ) {
+			CloseHandle( stream->mRead );
+			stream->mRead = nullptr;
+		}
 	}
-	if( mErrorReadThread && mErrorReadThread->joinable() ) {
-		mErrorReadThread->join();
+#else
+	if( mProcessRunning ) {
+		int status;
+		pid_t result;
+		do {
+			result = waitpid( mPid, &status, 0 );
+		} while( result == -1 && errno == EINTR );
+		// And get its exit code
+		if( result == mPid ) {
+			mExitCode = getExitCode( status );
+		}
+		mProcessRunning = false;
 	}
 
-#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
-	// Close Handles
-	if( mOutputRead ) {
-		CloseHandle( mOutputRead );
-		mOutputRead = nullptr;
-	}
-	if( mErrorRead ) {
-		CloseHandle( mErrorRead );
-		mErrorRead = nullptr;
+	// Wait for the reader to reach the end of StdOut and StdErr and close Handles
+	for( Stream* stream : { mOutput.get(), mError.get() } ) {
+		if( stream && stream->mRead != -1 ) {
+			stream->waitClosed();
+			ProcessReader::instance().remove( stream->mRead );
+			closeFd( stream->mRead );
+		}
 	}
 #endif
 
-	return exitCode;
+	return mExitCode;
 }
\ No newline at end of file
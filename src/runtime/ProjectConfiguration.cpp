@@ -21,6 +21,7 @@
 #include "runtime/ProjectConfiguration.h"
 #include "cinder/app/App.h"
 
+#include <fstream>
 #include <sstream>
 
 using namespace std;
@@ -29,6 +30,23 @@ using namespace ci::app;
 
 namespace runtime {
 
+namespace {
+	//! Returns the value of an entry of a CMakeCache.txt, or an empty string
+	string readCMakeCacheEntry( const fs::path &cachePath, const string &name )
+	{
+		ifstream cache( cachePath );
+		string line;
+		while( getline( cache, line ) ) {
+			// NAME:TYPE=VALUE
+			if( line.compare( 0, name.size(), name ) == 0 && line.size() > name.size() && line[name.size()] == ':' ) {
+				auto separator = line.find( '=' );
+				return separator == string::npos ? string() : line.substr( separator + 1 );
+			}
+		}
+		return string();
+	}
+} // anonymous namespace
+
 ProjectConfiguration::ProjectConfiguration( const ci::fs::path &path )
 	: mProjectPath( path )
 {
@@ -46,10 +64,20 @@ ProjectConfiguration::ProjectConfiguration( const ci::fs::path &path )
 					break;
 				}
 			}
+			// the closest CMake build directory, where the executable usually is
+			if( mBuildDir.empty() && fs::exists( path / "compile_commands.json" ) ) {
+				mBuildDir = path;
+			}
+		}
+
+		// without a .vcxproj the project is the CMake project of the build directory
+		if( mProjectPath.empty() && ! mBuildDir.empty() ) {
+			auto sourceDir = readCMakeCacheEntry( mBuildDir / "CMakeCache.txt", "CMAKE_HOME_DIRECTORY" );
+			mProjectPath = sourceDir.empty() ? mBuildDir / "compile_commands.json" : fs::path( sourceDir ) / "CMakeLists.txt";
 		}
 		
 		if( mProjectPath.empty() ) {
-			string msg = "Failed to find the .vcxproj path for this executable.";
+			string msg = "Failed to find the .vcxproj path or the CMake build directory for this executable.";
 			msg += " Searched up " + to_string( maxDepth ) + " levels from app path: " + appPath.string();
 			throw ProjectConfigurationException( msg );
 		}
@@ -75,6 +103,14 @@ ProjectConfiguration::ProjectConfiguration( const ci::fs::path &path )
 	mConfiguration += "_Shared";
 #endif
 		
+	// the configuration of a CMake build is its build type
+	if( ! mBuildDir.empty() && mProjectPath.extension() != ".vcxproj" ) {
+		auto buildType = readCMakeCacheEntry( mBuildDir / "CMakeCache.txt", "CMAKE_BUILD_TYPE" );
+		if( ! buildType.empty() ) {
+			mConfiguration = buildType;
+		}
+	}
+
 #if _MSC_VER == 1900
 	mPlatformToolset = "v140";
 #elif _MSC_VER >= 1910
@@ -88,7 +124,7 @@ string ProjectConfiguration::printToString() const
 {
 	stringstream str;
 
-	str << "projectPath: " << mProjectPath
+	str << "projectPath: " << mProjectPath << ", buildDir: " << mBuildDir
 		<< "\n\t- configuration: " << mConfiguration << ", platform: " << mPlatform << ", platformTarget: " << mPlatformTarget << ", platformToolset: " << mPlatformToolset;
 
 	return str.str();
@@ -124,6 +160,10 @@ ci::fs::path ProjectConfiguration::getProjectDir() const
 { 
 	return mProjectDir; 
 }
+ci::fs::path ProjectConfiguration::getBuildDir() const
+{ 
+	return mBuildDir; 
+}
 
 void ProjectConfiguration::setConfiguration( const std::string &config )
 { 
@@ -149,5 +189,9 @@ void ProjectConfiguration::setProjectDir( const ci::fs::path &dir )
 { 
 	mProjectDir = dir; 
 }
+void ProjectConfiguration::setBuildDir( const ci::fs::path &dir )
+{ 
+	mBuildDir = dir; 
+}
 
 }
\ No newline at end of file
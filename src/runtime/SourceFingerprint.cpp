@@ -0,0 +1,208 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+ 
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "runtime/SourceFingerprint.h"
+#include "runtime/Hash.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+
+	inline bool isIdentifierChar( char c )
+	{
+		return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ) || c == '_' || static_cast<unsigned char>( c ) >= 0x80;
+	}
+	inline bool isDigit( char c )
+	{
+		return c >= '0' && c <= '9';
+	}
+	inline bool isSpace( char c )
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+	}
+	
+	// returns the length of the line splice (backslash followed by a line end) at p, or 0 if there's none
+	inline size_t getSpliceLength( const char* p, const char* end )
+	{
+		if( p < end && *p == '\\' ) {
+			if( p + 1 < end && p[1] == '\n' ) {
+				return 2;
+			}
+			if( p + 2 < end && p[1] == '\r' && p[2] == '\n' ) {
+				return 3;
+			}
+		}
+		return 0;
+	}
+
+	inline bool isLiteralPrefix( string_view prefix )
+	{
+		return prefix == "L" || prefix == "u" || prefix == "U" || prefix == "u8" || prefix == "R" || prefix == "LR" || prefix == "uR" || prefix == "UR" || prefix == "u8R";
+	}
+
+	// returns the end of the string or character literal starting with the quote at p
+	const char* skipLiteral( const char* p, const char* end, bool raw )
+	{
+		if( raw ) {
+			// R"delimiter( ... )delimiter"
+			const char* open = find( p + 1, end, '(' );
+			if( open == end ) {
+				return end;
+			}
+			const string closing = ")" + string( p + 1, open ) + "\"";
+			const char* close = search( open + 1, end, closing.begin(), closing.end() );
+			return close == end ? end : close + closing.size();
+		}
+
+		const char quote = *p++;
+		while( p < end && *p != quote && *p != '\n' ) {
+			if( size_t splice = getSpliceLength( p, end ) ) {
+				p += splice;
+			}
+			else {
+				p += ( *p == '\\' && p + 1 < end ) ? 2 : 1;
+			}
+		}
+		return ( p < end && *p == quote ) ? p + 1 : p;
+	}
+
+} // anonymous namespace
+
+uint64_t SourceFingerprint::compute( std::string_view source )
+{
+	Hash hash;
+	const char* p = source.data();
+	const char* end = p + source.size();
+	bool lineStart = true;	// only whitespace and comments since the last line end
+	bool directive = false;	// inside a preprocessor directive
+	bool spaced = false;	// whitespace or comments since the last token
+
+	auto addToken = [&]( const char* begin, const char* tokenEnd ) {
+		// whitespace only matters inside directives (ex. "#define F(x)" and "#define F (x)")
+		if( directive && spaced ) {
+			hash.update( uint64_t( 1 ) ).update( " " );
+		}
+		// tokens are length-prefixed so that adjacent tokens can't be confused with a single one
+		hash.update( uint64_t( tokenEnd - begin ) ).update( begin, tokenEnd - begin );
+		lineStart = false;
+		spaced = false;
+	};
+
+	while( p < end ) {
+		const char c = *p;
+		if( c == '\n' ) {
+			if( directive ) {
+				spaced = false;
+				addToken( p, p + 1 );
+				directive = false;
+			}
+			lineStart = true;
+			spaced = false;
+			++p;
+		}
+		else if( isSpace( c ) ) {
+			spaced = true;
+			++p;
+		}
+		else if( size_t splice = getSpliceLength( p, end ) ) {
+			// splices can join two tokens, keep them in a normalized form
+			static const char sSplice[] = "\\\n";
+			addToken( sSplice, sSplice + 2 );
+			p += splice;
+		}
+		else if( c == '/' && p + 1 < end && p[1] == '/' ) {
+			while( p < end && *p != '\n' ) {
+				size_t splice = getSpliceLength( p, end );
+				p += splice ? splice : 1;
+			}
+			spaced = true;
+		}
+		else if( c == '/' && p + 1 < end && p[1] == '*' ) {
+			size_t close = source.find( "*/", ( p - source.data() ) + 2 );
+			p = ( close == string_view::npos ) ? end : source.data() + close + 2;
+			spaced = true;
+		}
+		else if( c == '#' && lineStart ) {
+			directive = true;
+			spaced = false;
+			addToken( p, p + 1 );
+			++p;
+		}
+		else if( isIdentifierChar( c ) || ( c == '.' && p + 1 < end && isDigit( p[1] ) ) ) {
+			// identifiers, keywords and preprocessing numbers (ex. 1'000, 0x1p-3 or 1.5e+10f)
+			const char* begin = p++;
+			const bool number = isDigit( c ) || c == '.';
+			while( p < end ) {
+				if( isIdentifierChar( *p ) ) {
+					++p;
+				}
+				else if( number && ( *p == '.' || ( *p == '\'' && p + 1 < end && isIdentifierChar( p[1] ) ) ) ) {
+					++p;
+				}
+				else if( number && ( *p == '+' || *p == '-' ) && ( p[-1] == 'e' || p[-1] == 'E' || p[-1] == 'p' || p[-1] == 'P' ) ) {
+					++p;
+				}
+				else {
+					break;
+				}
+			}
+			// encoding prefixes belong to the literal that follows (ex. u8"text" or R"(text)")
+			if( ! number && p < end && ( *p == '"' || *p == '\'' ) && isLiteralPrefix( string_view( begin, p - begin ) ) ) {
+				p = skipLiteral( p, end, *p == '"' && p[-1] == 'R' );
+			}
+			addToken( begin, p );
+		}
+		else if( c == '"' || c == '\'' ) {
+			const char* begin = p;
+			p = skipLiteral( p, end, false );
+			addToken( begin, p );
+		}
+		else {
+			// runs of punctuation are kept together so that "a - -b" and "a --b" differ
+			const char* begin = p++;
+			while( p < end && ! isSpace( *p ) && *p != '\n' && ! isIdentifierChar( *p ) && *p != '"' && *p != '\'' && ! getSpliceLength( p, end )
+				&& ! ( *p == '/' && p + 1 < end && ( p[1] == '/' || p[1] == '*' ) ) ) {
+				++p;
+			}
+			addToken( begin, p );
+		}
+	}
+
+	return hash.getValue();
+}
+
+uint64_t SourceFingerprint::fromFile( const ci::fs::path &path )
+{
+	ifstream file( path.string(), ios::binary );
+	if( ! file.is_open() ) {
+		return 0;
+	}
+	const string source( ( istreambuf_iterator<char>( file ) ), istreambuf_iterator<char>() );
+	return compute( source );
+}
+
+} // namespace runtime